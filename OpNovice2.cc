@@ -26,10 +26,17 @@
 #include "ActionInitialization.hh"
 #include "PrimaryGeneratorAction.hh"
 #include "DetectorConstruction.hh"
+#include "FarmDriver.hh"
 #include "SteppingVerbose.hh"
 #include "RunAction.hh"
 #include "Run.hh"
+#include "RunParameters.hh"
+#include <algorithm>
+#include <cstdlib>
 #include <limits>
+#include <random>
+#include <string>
+#include <vector>
 
 #include "FTFP_BERT.hh"
 #include "G4EmStandardPhysics_option4.hh"
@@ -37,31 +44,274 @@
 #include "G4OpticalPhysics.hh"
 #include "G4RunManagerFactory.hh"
 #include "G4String.hh"
+#include "G4Threading.hh"
 #include "G4Types.hh"
 #include "G4UIExecutive.hh"
 #include "G4UImanager.hh"
 #include "G4VisExecutive.hh"
+#include "Randomize.hh"
 
 // [hI
 #define Interactive  // UIgƂiSHIFTED_POSITION_MODEOFFɂKvj
 //#define SHIFTED_POSITION_MODE  // XɂPmm炵Ǝ˂Ƃ
 
+namespace
+{
+// run manager flavour and number of threads, from the command line
+// (-m/--run-manager, -t/--threads), else from the OPNOVICE2_RUN_MANAGER and
+// OPNOVICE2_THREADS environment variables, else the Geant4 default run
+// manager with one thread per core
+struct ThreadingOptions
+{
+	G4RunManagerType type = G4RunManagerType::Default;
+	G4int threads = 0;
+	G4String typeSource = "default";
+	G4String threadsSource = "auto";
+	// the options as given on the command line, for the farm processes
+	std::vector<G4String> arguments;
+};
+
+// the batch job from the command line instead of the prompts (-o/--output,
+// -n/--events, -r/--runs), the seed of the random engine (--seed) and the
+// histogram files (--histograms NAME: run k writes NAME_run<k>.root);
+// --farm N runs the job as N processes, each started with --shard i
+struct BatchOptions
+{
+	G4String outputFileName;
+	G4int nEventsPerRun = 0;
+	G4int nRuns = 0;
+	G4long seed = 0;
+	G4bool hasSeed = false;
+	G4String histogramFile;
+	G4int farmProcesses = 0;
+	// process i of a farm: random stream i + 1 of the seed, and the output
+	// file holds the sums of the tallies (RunParameters::farmShard)
+	G4int shard = -1;
+
+	G4bool HasJob() const { return !outputFileName.empty() || nEventsPerRun > 0 || nRuns > 0; }
+};
+
+// an explicit choice is not overridden by G4RUN_MANAGER_TYPE
+G4bool ParseRunManagerType(const G4String& value, G4RunManagerType& type)
+{
+	if (value == "default") type = G4RunManagerType::Default;
+	else if (value == "serial") type = G4RunManagerType::SerialOnly;
+	else if (value == "mt") type = G4RunManagerType::MTOnly;
+	else if (value == "tasking") type = G4RunManagerType::TaskingOnly;
+	else return false;
+	return true;
+}
+
+// a number >= 0
+G4bool ParseNumber(const G4String& value, G4long& number)
+{
+	char* end = nullptr;
+	number = std::strtol(value.c_str(), &end, 10);
+	return end != value.c_str() && *end == '\0' && number >= 0;
+}
+
+// a positive number
+G4bool ParseCount(const G4String& value, G4int& count)
+{
+	G4long n = 0;
+	if (!ParseNumber(value, n) || n < 1) return false;
+	count = static_cast<G4int>(n);
+	return true;
+}
+
+// "auto" is the hardware concurrency
+G4bool ParseThreads(const G4String& value, G4int& threads)
+{
+	if (value == "auto")
+	{
+		threads = G4Threading::G4GetNumberOfCores();
+		return true;
+	}
+	return ParseCount(value, threads);
+}
+
+// removes the options from argv; false on an invalid value
+G4bool ParseThreadingOptions(int& argc, char** argv, ThreadingOptions& options)
+{
+	options.threads = G4Threading::G4GetNumberOfCores();
+	if (const char* env = std::getenv("OPNOVICE2_RUN_MANAGER"))
+	{
+		if (!ParseRunManagerType(env, options.type))
+		{
+			G4cerr << "OPNOVICE2_RUN_MANAGER: unknown run manager " << env << G4endl;
+			return false;
+		}
+		options.typeSource = "OPNOVICE2_RUN_MANAGER";
+	}
+	if (const char* env = std::getenv("OPNOVICE2_THREADS"))
+	{
+		if (!ParseThreads(env, options.threads))
+		{
+			G4cerr << "OPNOVICE2_THREADS: invalid number of threads " << env << G4endl;
+			return false;
+		}
+		options.threadsSource = "OPNOVICE2_THREADS";
+	}
+
+	int kept = 1;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const G4bool isType = arg == "-m" || arg == "--run-manager";
+		const G4bool isThreads = arg == "-t" || arg == "--threads";
+		if (!isType && !isThreads)
+		{
+			argv[kept++] = argv[i];
+			continue;
+		}
+		if (i + 1 == argc)
+		{
+			G4cerr << arg << ": missing value" << G4endl;
+			return false;
+		}
+		const G4String value = argv[++i];
+		options.arguments.push_back(arg);
+		options.arguments.push_back(value);
+		if (isType && !ParseRunManagerType(value, options.type))
+		{
+			G4cerr << arg << ": unknown run manager " << value
+				<< " (serial, mt, tasking or default)" << G4endl;
+			return false;
+		}
+		if (isThreads && !ParseThreads(value, options.threads))
+		{
+			G4cerr << arg << ": invalid number of threads " << value
+				<< " (a positive number or auto)" << G4endl;
+			return false;
+		}
+		(isType ? options.typeSource : options.threadsSource) = "command line";
+	}
+	argc = kept;
+	argv[argc] = nullptr;
+	return true;
+}
+
+// removes the options from argv; false on an invalid value
+G4bool ParseBatchOptions(int& argc, char** argv, BatchOptions& options)
+{
+	int kept = 1;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const G4bool isOutput = arg == "-o" || arg == "--output";
+		const G4bool isEvents = arg == "-n" || arg == "--events";
+		const G4bool isRuns = arg == "-r" || arg == "--runs";
+		const G4bool isSeed = arg == "--seed";
+		const G4bool isHistograms = arg == "--histograms";
+		const G4bool isFarm = arg == "--farm";
+		const G4bool isShard = arg == "--shard";
+		if (!isOutput && !isEvents && !isRuns && !isSeed && !isHistograms && !isFarm && !isShard)
+		{
+			argv[kept++] = argv[i];
+			continue;
+		}
+		if (i + 1 == argc)
+		{
+			G4cerr << arg << ": missing value" << G4endl;
+			return false;
+		}
+		const G4String value = argv[++i];
+		G4bool valid = true;
+		if (isOutput) options.outputFileName = value;
+		else if (isHistograms) options.histogramFile = value;
+		else if (isEvents) valid = ParseCount(value, options.nEventsPerRun);
+		else if (isRuns) valid = ParseCount(value, options.nRuns);
+		else if (isFarm) valid = ParseCount(value, options.farmProcesses);
+		else if (isShard)
+		{
+			G4long shard = 0;
+			valid = ParseNumber(value, shard);
+			options.shard = static_cast<G4int>(shard);
+		}
+		else
+		{
+			valid = ParseNumber(value, options.seed);
+			options.hasSeed = true;
+		}
+		if (!valid)
+		{
+			G4cerr << arg << ": invalid value " << value << G4endl;
+			return false;
+		}
+	}
+	argc = kept;
+	argv[argc] = nullptr;
+	return true;
+}
+
+void WaitForEnter()
+{
+	std::cout << "Press ENTER to exit." << std::endl;
+	std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+	std::cin.get();
+}
+}  // namespace
+
 
 int main(int argc, char** argv)
 {
+	ThreadingOptions threading;
+	BatchOptions batch;
+	if (!ParseThreadingOptions(argc, argv, threading) || !ParseBatchOptions(argc, argv, batch))
+	{
+		G4cerr << "usage: OpNovice2 [-m serial|mt|tasking|default] [-t N|auto]"
+			" [-o file] [-n events] [-r runs] [--seed S]"
+			" [--histograms name] [--farm N] [batch]" << G4endl;
+		return 1;
+	}
+
 	// --- [U[́io̓t@CAs񐔁A1񂠂̃Cxgj ---
-	std::string outputFileName;
-	std::cout << "t@C: ";
-	std::cin >> outputFileName;
+	// only what is not given on the command line is asked
+	G4bool prompted = false;
+	std::string outputFileName = batch.outputFileName;
+	if (outputFileName.empty())
+	{
+		std::cout << "t@C: ";
+		std::cin >> outputFileName;
+		prompted = true;
+	}
 
-	int nEventsPerRun = 0;
-	std::cout << "Ǝˉ: ";
-	std::cin >> nEventsPerRun;
+	int nEventsPerRun = batch.nEventsPerRun;
+	if (nEventsPerRun == 0)
+	{
+		std::cout << "Ǝˉ: ";
+		std::cin >> nEventsPerRun;
+		prompted = true;
+	}
 
-	int nRuns = 0;
-	std::cout << "JԂ: ";
-	std::cin >> nRuns;
+	int nRuns = batch.nRuns;
+	if (nRuns == 0)
+	{
+		std::cout << "JԂ: ";
+		std::cin >> nRuns;
+		prompted = true;
+	}
 
+	// --- t@[[h: the job is run by local processes of this program ---
+	if (batch.farmProcesses > 0)
+	{
+		FarmDriver farm(argv[0], batch.farmProcesses);
+		farm.SetOutputFileName(outputFileName);
+		farm.SetEvents(nEventsPerRun, nRuns);
+		farm.SetSeed(batch.hasSeed ? batch.seed : static_cast<G4long>(std::random_device()() >> 1));
+		for (const auto& arg : threading.arguments)
+			farm.AddArgument(arg);
+		// without an explicit choice the processes share the cores
+		if (threading.threadsSource == "auto")
+		{
+			farm.AddArgument("-t");
+			farm.AddArgument(std::to_string(std::max(1, threading.threads / batch.farmProcesses)));
+		}
+		const G4bool done = farm.Run();
+		if (prompted)
+			WaitForEnter();
+		return done ? 0 : 1;
+	}
 
 
 	// **SteppingVerbose Kp**
@@ -73,17 +323,32 @@ int main(int argc, char** argv)
 	G4UIExecutive* ui = nullptr;
 
 #ifdef Interactive
-	if (argc == 1)
+	if (argc == 1 && !batch.HasJob())
 		ui = new G4UIExecutive(argc, argv);
 #endif
 
 	// **RunManager ̍쐬**
-	auto runManager = G4RunManagerFactory::CreateRunManager();
+	// the number of threads is ignored by the sequential run manager; the
+	// actual choice is printed again by RunAction at the start of each run
+	auto runManager = G4RunManagerFactory::CreateRunManager(threading.type, threading.threads);
+	G4cout << "Run manager: " << G4RunManagerFactory::GetName(threading.type)
+		<< " (" << threading.typeSource << "), " << runManager->GetNumberOfThreads()
+		<< " threads (" << threading.threadsSource << ")" << G4endl;
 
-#ifdef G4MULTITHREADED
-	// }`Xbh[h̏ꍇ́A[U[OɃXbhݒ肷
-	runManager->SetNumberOfThreads(1); //Xbh̎w 12
-#endif
+	// the workers are seeded from the master engine. The processes of a
+	// farm share the seed and each takes the MixMax stream of its index:
+	// (seed, i + 1) selects a sequence of its own, not just a nearby seed
+	if (batch.hasSeed && batch.shard >= 0)
+	{
+		const long seeds[] = { batch.seed, batch.shard + 1L, 0 };
+		G4Random::setTheSeeds(seeds);
+		G4cout << "Random seed: " << batch.seed << ", stream " << batch.shard + 1 << G4endl;
+	}
+	else if (batch.hasSeed)
+	{
+		G4Random::setTheSeed(batch.seed);
+		G4cout << "Random seed: " << batch.seed << G4endl;
+	}
 
 	// --- Detector, Physics, Action ̏ ---
 	auto detector = new DetectorConstruction();
@@ -114,38 +379,58 @@ int main(int argc, char** argv)
 
 	// **UI}l[W[Ŏ擾**
 	G4UImanager* UImanager = G4UImanager::GetUIpointer();
+	// --histograms: a file per run, so that a farm can merge all of them
+	auto setHistogramFile = [&](int runIndex) {
+		if (!batch.histogramFile.empty())
+			UImanager->ApplyCommand("/analysis/setFileName " + batch.histogramFile
+				+ "_run" + std::to_string(runIndex));
+	};
+	if (batch.shard >= 0)
+	{
+		RunParameters params = RunParameters::GetPublished();
+		params.farmShard = true;
+		RunParameters::Publish(params);
+	}
 
 	// --- ob`[hŃV~[V[v@̃V~[VsꍇAUIg킸Ƀ[vBeamOn()Ăяo
 	// e run ŁAƎˈʒuX -10`10 mm ͈̔́i1 mm ݁jł炵ȂV~[Vs
 #ifdef SHIFTED_POSITION_MODE
-	for (int runIndex = 0; runIndex < nRuns; ++runIndex)
+	// XW -10 mm  10 mm ܂ 1 mm ݂ŕύX
+	// all the points are events of one BeamOn, so that the workers stay busy
+	// across the points; Run writes one line per point
+	RunParameters params = RunParameters::GetPublished();
+	params.scanOrigins.clear();
+	for (G4double yShift = 10.0; yShift >= -10.0; yShift -= 1.0)
 	{
-		runManager->Initialize();
-		G4cout << "Starting run " << (runIndex + 1) << " / " << nRuns << " (SHIFTED MODE)" << G4endl;
-
-		// XW -10 mm  10 mm ܂ 1 mm ݂ŕύX
-		for (G4double yShift = 10.0; yShift >= -10.0; yShift -= 1.0)
-		{
-			// ÓIC^[tF[XgăO[oȌ_VtglXV
-			PrimaryGeneratorAction::SetGlobalOriginShiftY(yShift);
+		G4ThreeVector origin = params.sourceOrigin;
+		origin.setY(yShift * mm);
+		params.scanOrigins.push_back(origin);
+	}
+	params.eventsPerPoint = nEventsPerRun;
+	RunParameters::Publish(params);
 
-			G4cout << "  yShift = " << yShift << " mm" << G4endl;
+	runManager->Initialize();
+	for (int runIndex = 0; runIndex < nRuns; ++runIndex)
+	{
+		G4cout << "Starting run " << (runIndex + 1) << " / " << nRuns << " (SHIFTED MODE, "
+			<< params.GetNScanPoints() << " points)" << G4endl;
 
-			// w肳ꂽƎˉ񐔕̃Cxgs
-			runManager->BeamOn(nEventsPerRun);
+		// w肳ꂽƎˉ񐔕̃Cxgs
+		setHistogramFile(runIndex);
+		runManager->BeamOn(nEventsPerRun * params.GetNScanPoints());
 
-			//  V~[Vʂ́ARunAction̒Ńt@Co͂Oł
-		}
+		//  V~[Vʂ́ARunAction̒Ńt@Co͂Oł
 		G4cout << "Finished run " << (runIndex + 1) << G4endl;
 	}
 #else
 	// --- ]̃[h ---
 	if (!ui)
 	{
+		runManager->Initialize();
 		for (int i = 0; i < nRuns; ++i)
 		{
-			runManager->Initialize();
 			G4cout << "Starting run " << (i + 1) << " / " << nRuns << G4endl;
+			setHistogramFile(i);
 			runManager->BeamOn(nEventsPerRun);
 			G4cout << "Finished run " << (i + 1) << G4endl;
 		}
@@ -164,9 +449,8 @@ int main(int argc, char** argv)
 	delete runManager;
 	delete steppingVerbose;
 
-	std::cout << "Press ENTER to exit." << std::endl;
-	std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-	std::cin.get();
+	if (prompted)
+		WaitForEnter();
 
 	return 0;
 }
@@ -32,7 +32,6 @@
 #define ActionInitialization_h 1
 
 class DetectorConstruction;
-class PrimaryGeneratorAction;  // ǉFvC}NX̑O錾
 
 #include "G4VUserActionInitialization.hh"
 #include "G4String.hh"
@@ -45,16 +44,13 @@ public:
 
 	void SetOutputFileName(const G4String& fname);
 	void BuildForMaster() const override;
+	// called concurrently by every worker thread: only creates the
+	// thread-local actions and must not modify this object
 	void Build() const override;
 
-	void SetPrimaryGenerator(PrimaryGeneratorAction* pg);
-	PrimaryGeneratorAction* GetPrimaryGenerator() const;
-
 private:
 	DetectorConstruction* fDetector;
 	G4String fOutputFileName; // o̓t@Cێ
-
-	mutable PrimaryGeneratorAction* fPrimaryGenerator = nullptr;    // --- PrimaryGeneratorActioñ|C^ێ郁oϐ ---
 };
 
 #endif
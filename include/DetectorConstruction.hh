@@ -35,17 +35,42 @@
 #define DetectorConstruction_h 1
 
 #include "globals.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
 #include "G4OpticalSurface.hh"
 #include "G4RunManager.hh"
+#include "G4VPhysicalVolume.hh"
 #include "G4VUserDetectorConstruction.hh"
 #include "G4UnionSolid.hh"
+#include "OpticalTables.hh"
 
 #include <CLHEP/Units/SystemOfUnits.h>
 
+#include <map>
+#include <vector>
+
 class DetectorMessenger;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+// Role of a logical volume in the detector stack. The roles are registered
+// once in Construct() so that the user actions can classify the pre/post
+// volumes of a step with an array lookup instead of comparing names.
+enum class VolumeRole : G4int
+{
+	None = 0,
+	World,
+	Tank,
+	Scintillator,
+	Guide,
+	Reflector,
+	Grease,
+	Foil,
+	Frame
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
 public:
@@ -53,10 +78,42 @@ public:
 	~DetectorConstruction() override;
 
 	G4VPhysicalVolume* Construct() override;
+	void ConstructSDandField() override;
 
 	G4VPhysicalVolume* GetTank() { return fTank; }
 	G4double GetTankXSize() { return fTank_x; }
 
+	// volume role lookup, indexed by the logical volume instance ID
+	inline VolumeRole GetVolumeRole(const G4LogicalVolume* lv) const
+	{
+		const auto id = static_cast<std::size_t>(lv->GetInstanceID());
+		return id < fVolumeRoles.size() ? fVolumeRoles[id] : VolumeRole::None;
+	}
+	inline VolumeRole GetVolumeRole(const G4VPhysicalVolume* pv) const
+	{
+		return pv ? GetVolumeRole(pv->GetLogicalVolume()) : VolumeRole::None;
+	}
+
+	// RINDEX, ABSLENGTH, GROUPVEL, ... of every material resampled on
+	// uniform energy grids. Built at /run/initialize and by the master at
+	// the start of each run, after the macro commands have changed the
+	// MPTs; read-only during the run.
+	void BuildOpticalTables();
+	const OpticalTables& GetOpticalTables() const { return fOpticalTables; }
+
+	// /opnovice2/scintFraction: only the fraction f of the scintillation
+	// photons of a material is generated, each with weight 1/f. The master
+	// rescales SCINTILLATIONYIELD and RESOLUTIONSCALE at the start of each
+	// run, so values set with /opnovice2/boxConstProperty* are picked up.
+	void SetScintFraction(const G4String& material, G4double fraction);
+	void ApplyScintFractions();
+	// 1/f for the photons created in this material, 1 if it is not scaled
+	inline G4double GetScintWeight(const G4Material* material) const
+	{
+		const auto index = static_cast<std::size_t>(material->GetIndex());
+		return index < fScintWeights.size() ? fScintWeights[index] : 1.;
+	}
+
 	G4OpticalSurface* GetTankOpticalSurface() const;
 	G4OpticalSurface* GetTankOpticalSurface2() const;
 	G4OpticalSurface* GetTankOpticalSurfacePET() const;
@@ -412,6 +469,23 @@ private:
 	G4MaterialPropertiesTable* fSurfaceMPTR = nullptr;
 
 	DetectorMessenger* fDetectorMessenger = nullptr;
+
+	void RegisterVolumeRole(const G4LogicalVolume* lv, VolumeRole role);
+	std::vector<VolumeRole> fVolumeRoles;
+
+	// the unscaled constants are kept to notice when they are set again
+	struct ScintFraction
+	{
+		G4double fraction = 1.;
+		G4double yield = -1.;
+		G4double resolution = -1.;
+		G4double scaledYield = -1.;
+		G4double scaledResolution = -1.;
+	};
+	std::map<G4String, ScintFraction> fScintFractions;
+	std::vector<G4double> fScintWeights;  // by material index
+
+	OpticalTables fOpticalTables;
 };
 
 #endif /*DetectorConstruction_h*/
@@ -111,6 +111,10 @@ private:
 	G4UIcmdWithAString* fWorldMatPropVectorCmd = nullptr;
 	G4UIcmdWithAString* fWorldMatPropConstCmd = nullptr;
 	G4UIcmdWithAString* fWorldMaterialCmd = nullptr;
+
+	// scintillation photon generation fraction per material
+	G4UIcommand* fScintFractionCmd = nullptr;
+	G4UIcmdWithoutParameter* fDumpOpticalTablesCmd = nullptr;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
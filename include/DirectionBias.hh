@@ -0,0 +1,79 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/include/DirectionBias.hh
+/// \brief Definition of the DirectionBias class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef DirectionBias_h
+#define DirectionBias_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <array>
+
+class G4VPhysicalVolume;
+
+// Solid-angle biasing of isotropic emission. With probability f the
+// direction is drawn uniformly inside the smallest cone around the target
+// volume's bounding box as seen from the emission point, otherwise over
+// 4 pi. The returned weight is the ratio of the isotropic to the sampled
+// density, so weighted counts stay unbiased; it is at most 1/(1-f).
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class DirectionBias
+{
+ public:
+  DirectionBias() = default;
+  ~DirectionBias() = default;
+
+  // fraction of the directions drawn inside the cone; 0 disables
+  void SetFraction(G4double val);
+  G4double GetFraction() const { return fFraction; }
+  G4bool IsEnabled() const { return fFraction > 0. && fHasTarget; }
+
+  // bounding box of a volume placed in the world
+  void SetTarget(const G4VPhysicalVolume* target);
+
+  // returns the weight of the sampled direction
+  G4double Sample(const G4ThreeVector& position, G4ThreeVector& direction) const;
+
+ private:
+  G4bool GetCone(const G4ThreeVector& position, G4ThreeVector& axis,
+                 G4double& cosCone) const;
+
+  G4double fFraction = 0.;
+  G4bool fHasTarget = false;
+  std::array<G4ThreeVector, 8> fCorners;
+  G4ThreeVector fLower;
+  G4ThreeVector fUpper;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*DirectionBias_h*/
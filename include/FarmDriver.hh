@@ -0,0 +1,99 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/include/FarmDriver.hh
+/// \brief Definition of the FarmDriver class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef FarmDriver_h
+#define FarmDriver_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+// Runs a batch job as N local OpNovice2 processes (--farm N) and merges
+// their results, so that a job can use more than the threads of one process.
+// Process i gets 1/N of the events of each run, the random stream i + 1 of
+// the seed S and its own output shard <name>_shard<i>.txt, histogram files
+// <name>_shard<i>_run<k>.root and log <name>_shard<i>.log; the run manager
+// and thread options of the driver are passed on, and the environment
+// (G4FORCE_RUN_MANAGER_TYPE, G4FORCENUMBEROFTHREADS, OPNOVICE2_*) is
+// inherited.
+// The shards hold the sums and sums of squares of the tallies, so that
+// the merged lines appended to <name>.txt, and their errors, are those of
+// one process running all the events. The histograms of run k are merged
+// into opnovice2_run<k>.root and those of all the runs into opnovice2.root.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class FarmDriver
+{
+ public:
+  FarmDriver(const G4String& program, G4int nProcesses);
+  ~FarmDriver() = default;
+
+  // the output file name as given to a single process
+  void SetOutputFileName(const G4String& name);
+  void SetEvents(G4int eventsPerRun, G4int nRuns);
+  void SetSeed(G4long seed) { fSeed = seed; }
+  // passed to every process (run manager and thread options)
+  void AddArgument(const G4String& arg) { fArguments.push_back(arg); }
+
+  // launches the processes, waits for them and merges the shards; false if
+  // a process failed (the shards of the others are still merged)
+  G4bool Run();
+
+ private:
+  struct Shard
+  {
+    G4int index = 0;
+    G4int events = 0;  // per run
+    G4String name;     // <name>_shard<i>, without extension
+    G4int status = 0;
+    G4double seconds = 0.;
+  };
+
+  static G4String GetHistogramFile(const G4String& name, G4int run);
+  G4String GetCommand(const Shard& shard) const;
+  void Execute(Shard& shard) const;
+  void MergeCounters(const std::vector<const Shard*>& shards) const;
+  void MergeHistograms(const std::vector<const Shard*>& shards) const;
+
+  G4String fProgram;
+  G4int fNProcesses;
+  G4String fStem = "default_output";
+  G4String fOutputFileName = "default_output.txt";
+  G4int fEventsPerRun = 0;
+  G4int fNRuns = 0;
+  G4long fSeed = 0;
+  std::vector<G4String> fArguments;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*FarmDriver_h*/
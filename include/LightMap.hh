@@ -0,0 +1,143 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/include/LightMap.hh
+/// \brief Definition of the LightMap class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef LightMap_h
+#define LightMap_h 1
+
+#include "globals.hh"
+#include "G4MaterialPropertyVector.hh"
+#include "G4ThreeVector.hh"
+#include "G4Transform3D.hh"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class DetectorConstruction;
+class G4VPhysicalVolume;
+class G4VSolid;
+
+// Light collection efficiency (LCE) map: a regular grid over the bounding
+// box of each Scintillator-role volume (see DetectorConstruction), with one
+// tally per cell of the photons emitted there, the photons that reached
+// the Tank and the first two moments of their arrival time.
+//
+// The grid is rebuilt from the geometry at the start of each run. Maps
+// are written to lce_<hash>.bin, where the hash covers the grid, the
+// placed volumes and all material and optical surface property tables, so
+// a stored map can only be read back into the configuration it was made
+// for. A map read back is used by the fast optical mode, see
+// StackingAction.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class LightMap
+{
+ public:
+  struct Cell
+  {
+    G4double emitted = 0.;
+    G4double detected = 0.;
+    G4double sumTime = 0.;   // of the detected photons
+    G4double sumTime2 = 0.;
+  };
+
+  LightMap() = default;
+  ~LightMap() = default;
+
+  // number of cells along the local x, y, z axes of each volume
+  void SetGrid(G4int nx, G4int ny, G4int nz);
+
+  // lays the grid over the Scintillator-role volumes below world and
+  // clears the tallies
+  void Build(const DetectorConstruction* detector,
+             const G4VPhysicalVolume* world);
+  void Reset();
+
+  G4int GetNCells() const { return static_cast<G4int>(fCells.size()); }
+  std::uint64_t GetHash() const { return fHash; }
+  G4String GetFileName() const;
+
+  // uniform point inside the scintillator in the given cell, with an
+  // energy sampled from its SCINTILLATIONCOMPONENT1 spectrum; false when
+  // no point of the cell could be found inside the solid
+  G4bool SampleEmission(G4int cell, G4ThreeVector& position,
+                        G4double& energy) const;
+
+  // cell containing a global point, -1 outside the mapped scintillators
+  // or in a cell without photons
+  G4int FindCell(const G4ThreeVector& position) const;
+  // fraction of the photons emitted in the cell that reached the Tank
+  G4double GetEfficiency(G4int cell) const
+  {
+    const Cell& tally = fCells[cell];
+    return tally.emitted > 0. ? tally.detected / tally.emitted : 0.;
+  }
+  // arrival time after emission, from the mean and rms of the cell
+  G4double SampleArrivalTime(G4int cell) const;
+
+  void AddEvent(G4int cell, G4double emitted, G4double detected,
+                G4double sumTime, G4double sumTime2);
+  const Cell& GetCell(G4int cell) const { return fCells[cell]; }
+  void Merge(const LightMap& other);
+
+  G4bool Write(const G4String& fileName) const;
+  // reads the tallies of a map written for the same hash and grid
+  G4bool Read(const G4String& fileName);
+  void Print() const;
+
+ private:
+  struct Volume
+  {
+    G4String name;
+    const G4VSolid* solid = nullptr;
+    G4Transform3D toGlobal;
+    G4Transform3D toLocal;
+    G4ThreeVector lower;  // local bounding box
+    G4ThreeVector upper;
+    G4int firstCell = 0;
+    // cumulative emission spectrum
+    std::vector<G4double> energies;
+    std::vector<G4double> integral;
+  };
+
+  void AddVolumes(const DetectorConstruction* detector,
+                  const G4VPhysicalVolume* pv, const G4Transform3D& toMother);
+  const Volume* FindVolume(G4int cell) const;
+
+  std::array<G4int, 3> fGrid = { { 10, 10, 10 } };
+  std::vector<Volume> fVolumes;
+  std::vector<Cell> fCells;
+  std::uint64_t fHash = 0;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*LightMap_h*/
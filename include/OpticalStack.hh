@@ -0,0 +1,171 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/include/OpticalStack.hh
+/// \brief Definition of the OpticalStack class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef OpticalStack_h
+#define OpticalStack_h 1
+
+#include "globals.hh"
+#include "G4OpBoundaryProcess.hh"
+#include "G4ThreeVector.hh"
+
+#include <array>
+#include <vector>
+
+class DetectorConstruction;
+class G4VPhysicalVolume;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// Outcome of traced photons. The boundary status is that of the first
+// surface each photon meets, like the SteppingAction boundary statistics.
+struct RayTraceTally
+{
+  static constexpr std::size_t kNStatus =
+    CoatedDielectricFrustratedTransmission + 1;
+
+  G4double photons = 0.;
+  G4double detected = 0.;       // entered a Tank-role layer
+  G4double absorbed = 0.;       // bulk absorption
+  G4double absorbedPrior = 0.;  // bulk absorption before the first surface
+  G4double rayleigh = 0.;       // scatterings
+  G4double surface = 0.;        // absorbed at a surface
+  G4double escaped = 0.;        // left the stack into the world
+  G4double lost = 0.;           // still alive after the step limit
+  std::array<G4double, kNStatus> firstStatus{};
+
+  void Merge(const RayTraceTally& other);
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// Structure-of-arrays batch of photons, so that the per-step kernels of
+// OpticalStack::Trace() run over contiguous arrays
+struct PhotonBatch
+{
+  static constexpr std::size_t kSize = 256;
+
+  std::size_t size = 0;
+  alignas(64) std::array<G4double, kSize> x{};
+  alignas(64) std::array<G4double, kSize> y{};
+  alignas(64) std::array<G4double, kSize> z{};
+  alignas(64) std::array<G4double, kSize> dx{};
+  alignas(64) std::array<G4double, kSize> dy{};
+  alignas(64) std::array<G4double, kSize> dz{};
+  std::array<G4int, kSize> bin{};    // energy bin of the property tables
+  std::array<G4int, kSize> layer{};
+  std::array<G4int, kSize> alive{};
+  std::array<G4int, kSize> first{};  // has not met a surface yet
+
+  G4bool IsFull() const { return size == kSize; }
+  void Clear() { size = 0; }
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// Standalone optical photon transport through the detector stack, as a
+// planar stack of layers along z. The layers are the world daughters that
+// contain the z axis, each reduced to its bounding box; reflector volumes
+// around the axis are kept as lateral reflectors. RINDEX, ABSLENGTH and
+// RAYLEIGH are tabulated on a common energy grid. The photons see
+// bulk absorption, Rayleigh scattering (1 + cos^2), unpolarized Fresnel
+// reflection/refraction between layers and with the world, and specular
+// reflection on dielectric_metal surfaces. Surface finishes are taken as
+// polished.
+
+class OpticalStack
+{
+ public:
+  OpticalStack() = default;
+  ~OpticalStack() = default;
+
+  // returns false when no layer with a RINDEX is crossed by the z axis
+  G4bool Build(const DetectorConstruction* detector,
+               const G4VPhysicalVolume* world);
+  G4bool IsBuilt() const { return !fLayers.empty(); }
+
+  // appends a photon to the batch; false if it is outside every layer
+  G4bool Add(PhotonBatch& batch, const G4ThreeVector& position,
+             const G4ThreeVector& direction, G4double energy) const;
+  // transports the batch to completion and clears it
+  void Trace(PhotonBatch& batch, RayTraceTally& tally) const;
+
+  void Print() const;
+
+ private:
+  enum Property { kRindex = 0, kAbsLength, kRayleigh, kNProperties };
+
+  struct Layer
+  {
+    G4String name;
+    G4double lower[3] = { 0., 0., 0. };
+    G4double upper[3] = { 0., 0., 0. };
+    G4bool opaque = false;    // no RINDEX: photons stop at its surface
+    G4bool detector = false;  // Tank role
+    G4bool metal = false;     // dielectric_metal surface to the world
+    G4int reflector = -1;     // lateral reflector outside a dielectric side
+    G4int below = -1;         // touching neighbours, -1 for the world
+    G4int above = -1;
+  };
+
+  struct Reflector
+  {
+    G4double zLow = 0.;
+    G4double zHigh = 0.;
+  };
+
+  G4int FindLayer(const G4ThreeVector& position) const;
+  G4int GetBin(G4double energy) const;
+  G4double GetProperty(G4int layer, G4int bin, Property property) const
+  {
+    return fProperties[(static_cast<std::size_t>(layer) * fNBins + bin) * kNProperties
+                       + property];
+  }
+  // unpolarized Fresnel at a face with normal along axis (+-1): returns
+  // the boundary status and updates the direction of photon i
+  G4OpBoundaryProcessStatus Fresnel(PhotonBatch& batch, std::size_t i,
+                                    G4int axis, G4double n1, G4double n2) const;
+
+  std::vector<Layer> fLayers;
+  std::vector<Reflector> fReflectors;
+
+  // energy grid and the tables, flattened as [layer][bin][property]
+  G4int fNBins = 64;
+  G4double fEnergyMin = 0.;
+  G4double fEnergyMax = 0.;
+  std::vector<G4double> fProperties;
+  std::vector<G4double> fWorldRindex;             // [bin]
+  std::vector<G4double> fSurfaceReflectivity;     // [layer][bin], metal sides
+  std::vector<G4double> fReflectorReflectivity;   // [reflector][bin]
+
+  static constexpr G4int kMaxSteps = 10000;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*OpticalStack_h*/
@@ -0,0 +1,137 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/include/OpticalTables.hh
+/// \brief Definition of the OpticalTables class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef OpticalTables_h
+#define OpticalTables_h 1
+
+#include "globals.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertyVector.hh"
+
+#include <algorithm>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// A material property vector resampled on a uniform energy grid, so that
+// a lookup is one multiply and an index instead of a binary search. The
+// number of bins is doubled until the linear interpolation of the grid
+// reproduces the source vector within the tolerance everywhere, or until
+// the maximum number of bins is reached.
+
+class UniformTable
+{
+ public:
+  UniformTable() = default;
+  ~UniformTable() = default;
+
+  // relative tolerance on the largest |value| of the source vector; false
+  // if the table is not within the tolerance
+  G4bool Build(const G4MaterialPropertyVector& source, G4double tolerance = 1.e-4,
+               G4int maxBins = 4096);
+  G4bool IsValid() const { return fValues.size() > 1; }
+
+  // clamped to the energy range of the source, like
+  // G4MaterialPropertyVector::Value()
+  inline G4double Value(G4double energy) const
+  {
+    const G4double x = std::min(std::max((energy - fEnergyMin) * fInvStep, 0.), fLast);
+    const auto i = std::min(static_cast<std::size_t>(x), fValues.size() - 2);
+    return fValues[i] + (x - i) * (fValues[i + 1] - fValues[i]);
+  }
+
+  // largest absolute difference to the source over the whole range
+  G4double GetMaxDeviation() const { return fMaxDeviation; }
+  std::size_t GetNBins() const { return fValues.size(); }
+  std::size_t GetNSourcePoints() const { return fNSourcePoints; }
+  G4double GetEnergyMin() const { return fEnergyMin; }
+  G4double GetEnergyMax() const { return fEnergyMax; }
+  G4double GetBinValue(std::size_t i) const { return fValues[i]; }
+
+ private:
+  std::vector<G4double> fValues;
+  G4double fEnergyMin = 0.;
+  G4double fEnergyMax = 0.;
+  G4double fInvStep = 0.;
+  G4double fLast = 0.;
+  G4double fMaxDeviation = 0.;
+  std::size_t fNSourcePoints = 0;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// The uniform tables of the optical properties of every material, indexed
+// by material index. Built by the master at /run/initialize and again at
+// the start of each run, and only read by the workers during the run.
+
+class OpticalTables
+{
+ public:
+  enum Property
+  {
+    kRindex = 0,
+    kAbsLength,
+    kGroupVel,
+    kRayleigh,
+    kWLSAbsLength,
+    kWLSAbsLength2,
+    kNProperties
+  };
+
+  OpticalTables() = default;
+  ~OpticalTables() = default;
+
+  void Build();
+
+  // nullptr if the material has no such property
+  inline const UniformTable* Get(const G4Material* material, Property property) const;
+  // true if any material has the property
+  G4bool Has(Property property) const;
+
+  // one line per table; with values, every bin as well
+  void Dump(G4bool values) const;
+
+ private:
+  std::vector<UniformTable> fTables;  // [material index][property]
+  std::vector<G4String> fMaterialNames;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline const UniformTable* OpticalTables::Get(const G4Material* material,
+                                              Property property) const
+{
+  const std::size_t index = material->GetIndex() * kNProperties + property;
+  return index < fTables.size() && fTables[index].IsValid() ? &fTables[index] : nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*OpticalTables_h*/
@@ -36,9 +36,14 @@
 #include "globals.hh"
 #include "G4ParticleGun.hh"
 #include "G4VUserPrimaryGeneratorAction.hh"
+#include "DirectionBias.hh"
+#include "LightMap.hh"
+#include "RunParameters.hh"
 
 
+class DetectorConstruction;
 class G4Event;
+class G4VPhysicalVolume;
 class PrimaryGeneratorMessenger;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -60,15 +65,38 @@ public:
 	G4bool GetPolarized() { return fPolarized; };
 	G4double GetPolarization() { return fPolarization; }
 
+	// light map run: each event emits photons isotropically from one cell
+	// of the scintillator grid, see LightMap
+	void SetLightMapMode(G4bool val) { fLightMapMode = val; }
+	G4bool GetLightMapMode() const { return fLightMapMode; }
+	void SetLightMapGrid(G4int nx, G4int ny, G4int nz) { fLightMap.SetGrid(nx, ny, nz); }
+	void SetLightMapPhotons(G4int val) { fLightMapPhotons = val > 0 ? val : 1; }
+	// fast optical mode: scintillation photons are not tracked, their
+	// detection is sampled from the stored map (see StackingAction)
+	void SetLightMapFast(G4bool val) { fLightMapFast = val; }
+	G4bool GetLightMapFast() const { return fLightMapFast; }
+	// lays the grid over the current geometry; called at the start of a run
+	void BuildLightMap(const DetectorConstruction* detector, const G4VPhysicalVolume* world);
+	// reads the stored map for the grid built by BuildLightMap()
+	G4bool LoadLightMap();
+	const LightMap& GetLightMap() const { return fLightMap; }
+
+	// solid-angle biasing towards the Tank: the gun direction of a moving
+	// primary, and the decay products of an ion at rest (StackingAction)
+	DirectionBias& GetDirectionBias() { return fDirectionBias; }
+
 	// originShiftXݒ肷邽߂̏]setter/getteriCX^XƁj
 	void SetOriginShiftY(G4double y) { fOriginShiftY = y; }
 	G4double GetOriginShiftY() const { return fOriginShiftY; }
 
-	// S[J[ŋL錴_VtglݒE擾
-	static void SetGlobalOriginShiftY(G4double y) { fGlobalOriginShiftY = y; }
-	static G4double GetGlobalOriginShiftY() { return fGlobalOriginShiftY; }
+	// this thread's copy of the published source parameters, set by
+	// RunAction at the start of each run
+	void SetRunParameters(const RunParameters& params) { fRunParameters = params; }
+	const RunParameters& GetRunParameters() const { return fRunParameters; }
 
 private:
+	void GenerateLightMapPhotons(G4Event*);
+
 	G4ParticleGun* fParticleGun = nullptr;
 	G4bool fIsAlphaSource; //  or  ؂ւtO
 	PrimaryGeneratorMessenger* fGunMessenger = nullptr;
@@ -76,7 +104,13 @@ private:
 	G4bool fPolarized = false;
 	G4double fPolarization = 0.;
 	G4double fOriginShiftY = 0.0;    // CX^XƂ originShiftXiPʂmmjBl0.0 mmƂB
-	static G4double fGlobalOriginShiftY;	  // S[J[ʂ̌_VtgXimmPʁjAl0.0
+	RunParameters fRunParameters;
+
+	G4bool fLightMapMode = false;
+	G4bool fLightMapFast = false;
+	G4int fLightMapPhotons = 1000;  // per event
+	LightMap fLightMap;
+	DirectionBias fDirectionBias;  // source directions towards the Tank (/opnovice2/gun/biasCone)
 };
 
 #endif /*PrimaryGeneratorAction_h*/
@@ -41,8 +41,11 @@
 
 class PrimaryGeneratorAction;
 class G4UIdirectory;
+class G4UIcmdWithADouble;
 class G4UIcmdWithADoubleAndUnit;
 class G4UIcmdWithABool;
+class G4UIcmdWithAnInteger;
+class G4UIcommand;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -59,6 +62,13 @@ class PrimaryGeneratorMessenger : public G4UImessenger
   G4UIdirectory* fGunDir = nullptr;
   G4UIcmdWithADoubleAndUnit* fPolarCmd = nullptr;
   G4UIcmdWithABool* fRandomDirectionCmd = nullptr;
+  G4UIcmdWithADouble* fBiasConeCmd = nullptr;
+
+  G4UIdirectory* fLightMapDir = nullptr;
+  G4UIcmdWithABool* fLightMapCmd = nullptr;
+  G4UIcommand* fLightMapGridCmd = nullptr;
+  G4UIcmdWithAnInteger* fLightMapPhotonsCmd = nullptr;
+  G4UIcmdWithABool* fLightMapFastCmd = nullptr;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
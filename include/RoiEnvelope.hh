@@ -0,0 +1,93 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/include/RoiEnvelope.hh
+/// \brief Definition of the RoiEnvelope class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef RoiEnvelope_h
+#define RoiEnvelope_h 1
+
+#include "globals.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+
+#include <map>
+#include <vector>
+
+class G4ParticleDefinition;
+class G4VPhysicalVolume;
+
+// Region of interest: the bounding box of all the placements in the world,
+// grown by a margin. A track in the world volume that is outside the box
+// and whose straight line does not come back into it can be stopped,
+// depending on the policy of its particle type.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class RoiEnvelope
+{
+ public:
+  RoiEnvelope() = default;
+  ~RoiEnvelope() = default;
+
+  void SetEnabled(G4bool val) { fEnabled = val; }
+  G4bool IsEnabled() const { return fEnabled; }
+
+  void SetMargin(G4double val) { fMargin = val; }
+  G4double GetMargin() const { return fMargin; }
+
+  // kill policy of a particle type by name; "all" sets the default for the
+  // types not listed
+  void SetKill(const G4String& particle, G4bool kill);
+
+  // computes the box from the daughters of the world and resolves the
+  // policies; returns false when there is nothing to enclose
+  G4bool Build(const G4VPhysicalVolume* world);
+
+  G4bool Kills(const G4ParticleDefinition* particle) const;
+  // outside the box and moving away from it
+  G4bool IsEscaping(const G4ThreeVector& position,
+                    const G4ThreeVector& direction) const;
+
+  void Print() const;
+
+ private:
+  G4bool fEnabled = false;
+  G4double fMargin = 10. * cm;
+
+  G4bool fKillDefault = true;
+  std::map<G4String, G4bool> fKillByName;
+  std::vector<G4bool> fKill;  // by particle instance ID, set in Build()
+
+  G4ThreeVector fLower;
+  G4ThreeVector fUpper;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*RoiEnvelope_h*/
@@ -34,12 +34,47 @@
 
 #include "G4OpBoundaryProcess.hh"
 #include "G4Run.hh"
+#include "LightMap.hh"
+#include "OpticalStack.hh"
+#include "RunParameters.hh"
+#include "TankSD.hh"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
 #include <string>
 #include <vector>
 
 
 class G4ParticleDefinition;
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// weighted count; the per-event sums give the statistical error
+struct Tally
+{
+	G4double sum = 0.;    // over the run
+	G4double sum2 = 0.;   // of the squared per-event sums
+	G4double event = 0.;  // current event
+
+	void Add(G4double weight = 1.) { event += weight; }
+	void EndOfEvent()
+	{
+		sum += event;
+		sum2 += event * event;
+		event = 0.;
+	}
+	void Merge(const Tally& other)
+	{
+		sum += other.sum;
+		sum2 += other.sum2;
+	}
+	// standard error of the run total
+	G4double GetError(G4int nEvents) const
+	{
+		return nEvents > 0 ? std::sqrt(std::max(sum2 - sum * sum / nEvents, 0.)) : 0.;
+	}
+};
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 class Run : public G4Run
 {
@@ -47,181 +82,117 @@ public:
 	Run();
 	~Run() override = default;
 
+	// the optical photon counters; all are weighted (TrackInformation weight)
+	enum TallyId
+	{
+		kDetected = 0,  // photons entering the Tank
+		kCerenkov,
+		kScintillation,
+		kRayleigh,
+		kWLSAbsorption,
+		kWLSEmission,
+		kWLS2Absorption,
+		kWLS2Emission,
+		kOpAbsorption,
+		kOpAbsorptionPrior,
+		kTotalSurface,
+		kOutOfGate,     // photons killed by the time gate
+		kNTallies
+	};
+	const Tally& GetTally(TallyId id) const { return fTallies[id]; }
+
+	// size of the boundary status table, one entry per G4OpBoundaryProcessStatus
+	static constexpr std::size_t kNBoundaryStatus =
+		CoatedDielectricFrustratedTransmission + 1;
+
 	// JEg֐
 	void IncrementAlphaCount() { fAlphaCount++; }
-	G4int GetAlphaCount() const { return fAlphaCount; } // JEg擾֐
+	G4double GetAlphaCount() const { return fAlphaCount; } // JEg擾֐
 
 	// JEg֐
 	void IncrementBetaCount() { fBetaCount++; }
-	G4int GetBetaCount() const { return fBetaCount; }
+	G4double GetBetaCount() const { return fBetaCount; }
 
 	// JEg֐
 	void IncrementGammaCount() { fGammaCount++; }
-	G4int GetGammaCount() const { return fGammaCount; }
+	G4double GetGammaCount() const { return fGammaCount; }
 
 	void ResetPhotonCount();
 	void AddPhotonCount();
-	void AddPhotonCountZW();
-	void AddPhotonCountZP();
-	void AddPhotonCountPZ();
+	// a photon reaching the Tank at the given global time
+	void AddPhotonArrival(G4double time, G4double weight = 1.);
 	void SetPrimary(G4ParticleDefinition* particle, G4double energy,
 		G4bool polarized, G4double polarization);
+	// the source parameters published for this run
+	void SetParameters(const RunParameters& params);
+	const RunParameters& GetParameters() const { return fParameters; }
 
 	//  particle energy
-	void AddCerenkovEnergy(G4double en) { fCerenkovEnergy += en; }
-	void AddScintillationEnergy(G4double en) { fScintEnergy += en; }
-	void AddWLSAbsorptionEnergy(G4double en) { fWLSAbsorptionEnergy += en; }
-	void AddWLSEmissionEnergy(G4double en) { fWLSEmissionEnergy += en; }
-	void AddWLS2AbsorptionEnergy(G4double en) { fWLS2AbsorptionEnergy += en; }
-	void AddWLS2EmissionEnergy(G4double en) { fWLS2EmissionEnergy += en; }
+	void AddCerenkovEnergy(G4double en, G4double w = 1.) { fCerenkovEnergy += w * en; }
+	void AddScintillationEnergy(G4double en, G4double w = 1.) { fScintEnergy += w * en; }
+	void AddWLSAbsorptionEnergy(G4double en, G4double w = 1.) { fWLSAbsorptionEnergy += w * en; }
+	void AddWLSEmissionEnergy(G4double en, G4double w = 1.) { fWLSEmissionEnergy += w * en; }
+	void AddWLS2AbsorptionEnergy(G4double en, G4double w = 1.) { fWLS2AbsorptionEnergy += w * en; }
+	void AddWLS2EmissionEnergy(G4double en, G4double w = 1.) { fWLS2EmissionEnergy += w * en; }
 
 	// number of particles
-	void AddCerenkov() { fCerenkovCount += 1; }
-	void AddScintillation() { fScintCount += 1; }
-	void AddRayleigh() { fRayleighCount += 1; }
-	void AddWLSAbsorption() { fWLSAbsorptionCount += 1; }
-	void AddWLSEmission() { fWLSEmissionCount += 1; }
-	void AddWLS2Absorption() { fWLS2AbsorptionCount += 1; }
-	void AddWLS2Emission() { fWLS2EmissionCount += 1; }
-
-	void AddOpAbsorption() { fOpAbsorption += 1; }
-	void AddOpAbsorptionPrior() { fOpAbsorptionPrior += 1; }
-
-	void AddFresnelRefraction() { fBoundaryProcs[FresnelRefraction] += 1; }
-	void AddFresnelReflection() { fBoundaryProcs[FresnelReflection] += 1; }
-	void AddTransmission() { fBoundaryProcs[Transmission] += 1; }
-	void AddTotalInternalReflection()
-	{
-		fBoundaryProcs[TotalInternalReflection] += 1;
-	}
-	void AddLambertianReflection()
-	{
-		fBoundaryProcs[LambertianReflection] += 1;
-	}
-	void AddLobeReflection() { fBoundaryProcs[LobeReflection] += 1; }
-	void AddSpikeReflection() { fBoundaryProcs[SpikeReflection] += 1; }
-	void AddBackScattering() { fBoundaryProcs[BackScattering] += 1; }
-	void AddAbsorption() { fBoundaryProcs[Absorption] += 1; }
-	void AddDetection() { fBoundaryProcs[Detection] += 1; }
-	void AddNotAtBoundary() { fBoundaryProcs[NotAtBoundary] += 1; }
-	void AddSameMaterial() { fBoundaryProcs[SameMaterial] += 1; }
-	void AddStepTooSmall() { fBoundaryProcs[StepTooSmall] += 1; }
-	void AddNoRINDEX() { fBoundaryProcs[NoRINDEX] += 1; }
-
-	void AddTotalSurface() { fTotalSurface += 1; }
-	void AddPolishedLumirrorAirReflection()
-	{
-		fBoundaryProcs[PolishedLumirrorAirReflection] += 1;
-	}
-	void AddPolishedLumirrorGlueReflection()
-	{
-		fBoundaryProcs[PolishedLumirrorGlueReflection] += 1;
-	}
-	void AddPolishedAirReflection()
-	{
-		fBoundaryProcs[PolishedAirReflection] += 1;
-	}
-	void AddPolishedTeflonAirReflection()
-	{
-		fBoundaryProcs[PolishedTeflonAirReflection] += 1;
-	}
-	void AddPolishedTiOAirReflection()
-	{
-		fBoundaryProcs[PolishedTiOAirReflection] += 1;
-	}
-	void AddPolishedTyvekAirReflection()
-	{
-		fBoundaryProcs[PolishedTyvekAirReflection] += 1;
-	}
-	void AddPolishedVM2000AirReflection()
-	{
-		fBoundaryProcs[PolishedVM2000AirReflection] += 1;
-	}
-	void AddPolishedVM2000GlueReflection()
-	{
-		fBoundaryProcs[PolishedVM2000GlueReflection] += 1;
-	}
+	void AddCerenkov(G4double w = 1.) { fTallies[kCerenkov].Add(w); }
+	void AddScintillation(G4double w = 1.) { fTallies[kScintillation].Add(w); }
+	void AddRayleigh(G4double w = 1.) { fTallies[kRayleigh].Add(w); }
+	void AddWLSAbsorption(G4double w = 1.) { fTallies[kWLSAbsorption].Add(w); }
+	void AddWLSEmission(G4double w = 1.) { fTallies[kWLSEmission].Add(w); }
+	void AddWLS2Absorption(G4double w = 1.) { fTallies[kWLS2Absorption].Add(w); }
+	void AddWLS2Emission(G4double w = 1.) { fTallies[kWLS2Emission].Add(w); }
 
-	void AddEtchedLumirrorAirReflection()
-	{
-		fBoundaryProcs[EtchedLumirrorAirReflection] += 1;
-	}
-	void AddEtchedLumirrorGlueReflection()
-	{
-		fBoundaryProcs[EtchedLumirrorGlueReflection] += 1;
-	}
-	void AddEtchedAirReflection()
-	{
-		fBoundaryProcs[EtchedAirReflection] += 1;
-	}
-	void AddEtchedTeflonAirReflection()
-	{
-		fBoundaryProcs[EtchedTeflonAirReflection] += 1;
-	}
-	void AddEtchedTiOAirReflection()
-	{
-		fBoundaryProcs[EtchedTiOAirReflection] += 1;
-	}
-	void AddEtchedTyvekAirReflection()
-	{
-		fBoundaryProcs[EtchedTyvekAirReflection] += 1;
-	}
-	void AddEtchedVM2000AirReflection()
-	{
-		fBoundaryProcs[EtchedVM2000AirReflection] += 1;
-	}
-	void AddEtchedVM2000GlueReflection()
-	{
-		fBoundaryProcs[EtchedVM2000GlueReflection] += 1;
-	}
+	void AddOpAbsorption(G4double w = 1.) { fTallies[kOpAbsorption].Add(w); }
+	void AddOpAbsorptionPrior(G4double w = 1.) { fTallies[kOpAbsorptionPrior].Add(w); }
 
-	void AddGroundLumirrorAirReflection()
-	{
-		fBoundaryProcs[GroundLumirrorAirReflection] += 1;
-	}
-	void AddGroundLumirrorGlueReflection()
-	{
-		fBoundaryProcs[GroundLumirrorGlueReflection] += 1;
-	}
-	void AddGroundAirReflection()
-	{
-		fBoundaryProcs[GroundAirReflection] += 1;
-	}
-	void AddGroundTeflonAirReflection()
-	{
-		fBoundaryProcs[GroundTeflonAirReflection] += 1;
-	}
-	void AddGroundTiOAirReflection()
-	{
-		fBoundaryProcs[GroundTiOAirReflection] += 1;
-	}
-	void AddGroundTyvekAirReflection()
-	{
-		fBoundaryProcs[GroundTyvekAirReflection] += 1;
-	}
-	void AddGroundVM2000AirReflection()
-	{
-		fBoundaryProcs[GroundVM2000AirReflection] += 1;
-	}
-	void AddGroundVM2000GlueReflection()
-	{
-		fBoundaryProcs[GroundVM2000GlueReflection] += 1;
-	}
+	// count a boundary status through the flat status table
+	void AddBoundaryStatus(G4OpBoundaryProcessStatus status, G4double w = 1.);
 
-	void AddDichroic() { fBoundaryProcs[Dichroic] += 1; }
-	void AddCoatedDielectricRefraction()
+	void AddTotalSurface(G4double w = 1.) { fTallies[kTotalSurface].Add(w); }
+	void AddOutOfGate(G4double w = 1.) { fTallies[kOutOfGate].Add(w); }
+
+	// photons traced by the standalone OpticalStack (StackingAction)
+	RayTraceTally& GetRayTrace() { return fRayTrace; }
+
+	// a track stopped by the ROI envelope (SteppingAction)
+	void AddRoiKill(const G4String& particle, G4double energy)
 	{
-		fBoundaryProcs[CoatedDielectricRefraction] += 1;
+		RoiKills& kills = fRoiKills[particle];
+		kills.tracks += 1;
+		kills.energy += energy;
 	}
-	void AddCoatedDielectricReflection()
+
+	// photons cut to the quantum efficiency band (StackingAction), after
+	// they were counted as created
+	enum SpectralCut
 	{
-		fBoundaryProcs[CoatedDielectricReflection] += 1;
-	}
-	void AddCoatedDielectricFrustratedTransmission()
+		kOutOfBand = 0,  // QE is zero at their energy
+		kRouletted,      // lost the roulette against the peak QE
+		kAccepted,       // tracked with the weight of the peak QE
+		kNSpectralCuts
+	};
+	void AddSpectralCut(SpectralCut cut) { fSpectralCuts[cut] += 1; }
+
+	// group velocity self-test (SteppingAction::CheckGroupVelocity)
+	void AddGroupVelocityCheck() { fGroupVelocityChecks += 1; }
+	void AddGroupVelocityViolation() { fGroupVelocityViolations += 1; }
+	G4long GetGroupVelocityViolations() const { return fGroupVelocityViolations; }
+	// largest difference of the GROUPVEL table (OpticalTables) from the
+	// material property vector, at the checked photon energies
+	void AddGroupVelocityTableDeviation(G4double deviation)
 	{
-		fBoundaryProcs[CoatedDielectricFrustratedTransmission] += 1;
+		fGroupVelocityTableDeviation = std::max(fGroupVelocityTableDeviation, deviation);
 	}
 
+	// light map run (/opnovice2/lightmap/enable): the photons of each event
+	// are tallied in the map cell they were emitted from
+	void SetLightMap(const LightMap& map);
+	G4bool IsLightMapRun() const { return fLightMapRun; }
+
+	// adds the Tank entries scored by TankSD in this event
+	void RecordEvent(const G4Event*) override;
 	void Merge(const G4Run*) override;
 
 	void EndOfRun();
@@ -234,6 +205,7 @@ private:
 	G4double fEkin = -1.;
 	G4bool fPolarized = false;
 	G4double fPolarization = 0.;
+	RunParameters fParameters;
 
 	G4double fCerenkovEnergy = 0.;
 	G4double fScintEnergy = 0.;
@@ -242,37 +214,59 @@ private:
 	G4double fWLS2AbsorptionEnergy = 0.;
 	G4double fWLS2EmissionEnergy = 0.;
 
-	// number of particles
-	G4int fCerenkovCount = 0;
-	G4int fScintCount = 0;
-	G4int fWLSAbsorptionCount = 0;
-	G4int fWLSEmissionCount = 0;
-	G4int fWLS2AbsorptionCount = 0;
-	G4int fWLS2EmissionCount = 0;
-	G4int fAlphaCount = 0; // ̓B
-	G4int fBetaCount = 0; // ̓B
-	G4int fGammaCount = 0; // ̓B
+	// optical photon counters
+	std::array<Tally, kNTallies> fTallies{};
 
-	// number of events
-	G4int fRayleighCount = 0;
+	// weighted Tank entries, see TankSD
+	G4double fAlphaCount = 0.; // ̓B
+	G4double fBetaCount = 0.; // ̓B
+	G4double fGammaCount = 0.; // ̓B
 
-	// non-boundary processes
-	G4int fOpAbsorption = 0;
+	// boundary proc
+	std::vector<Tally> fBoundaryProcs;
 
-	// prior to boundary:
-	G4int fOpAbsorptionPrior = 0;
+	G4long fGroupVelocityChecks = 0;
+	G4long fGroupVelocityViolations = 0;
+	G4double fGroupVelocityTableDeviation = 0.;
 
-	// boundary proc
-	std::vector<G4int> fBoundaryProcs;
+	std::array<G4long, kNSpectralCuts> fSpectralCuts{};
+
+	// ROI envelope kills by particle name
+	struct RoiKills
+	{
+		G4long tracks = 0;
+		G4double energy = 0.;
+	};
+	std::map<G4String, RoiKills> fRoiKills;
+
+	// tallies of each scan point, written one line per point
+	struct ScanPointTally
+	{
+		G4int events = 0;
+		Tally created;   // scintillation photons
+		Tally detected;
+		std::array<G4double, TankSD::kNSpecies> tank{};  // weighted Tank entries
+	};
+	std::vector<ScanPointTally> fScanPoints;
+	void PrintScan() const;
 
-	G4int fTotalSurface = 0;
-	G4int fPhotonCount;
-	G4int fPhotonCountZnSaWorld;
-	G4int fPhotonCountZnSPlastic;
-	G4int fPhotonCountPlasticZnS;
+	// ray tracer validation, compared with the tallies above in EndOfRun()
+	RayTraceTally fRayTrace;
+	void PrintRayTrace() const;
 
 	std::string outputFileName;
 
+	// light map tallies, and the arrivals of the current event
+	LightMap fLightMap;
+	G4bool fLightMapRun = false;
+	G4double fEventArrivals = 0.;
+	G4double fEventTimeSum = 0.;
+	G4double fEventTimeSum2 = 0.;
+
+	// hits collection IDs of TankSD, looked up at the first event
+	std::array<G4int, TankSD::kNSpecies> fTankHCIDs{};
+	G4bool fTankHCIDsResolved = false;
+
 };
 
 #endif /* Run_h */
@@ -41,18 +41,23 @@
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+class DetectorConstruction;
 class Run;
 class HistoManager;
 class PrimaryGeneratorAction;
+class RunParametersMessenger;
+class StepContext;
 
 class RunAction : public G4UserRunAction
 {
 public:
 	// }X^[pRXgN^
-	RunAction(const G4String& outputFileName);
+	RunAction(DetectorConstruction* detector, const G4String& outputFileName);
 
 	// [J[pRXgN^
-	RunAction(PrimaryGeneratorAction* primary, SteppingAction* stepping, const G4String& outputFileName);
+	// takes ownership of the worker's StepContext
+	RunAction(PrimaryGeneratorAction* primary, SteppingAction* stepping,
+		StepContext* context, const G4String& outputFileName);
 	~RunAction() override;
 
 	G4Run* GenerateRun() override;
@@ -64,7 +69,11 @@ private:
 	HistoManager* fHistoManager = nullptr;
 	PrimaryGeneratorAction* fPrimary = nullptr;
 	SteppingAction* fSteppingAction = nullptr;  // JEg_SteppingAction ǉ
+	StepContext* fStepContext = nullptr;
+	DetectorConstruction* fDetector = nullptr;
 	G4String fOutputFileName;
+	// /opnovice2/run/, on the master only (the single RunAction in serial mode)
+	RunParametersMessenger* fParametersMessenger = nullptr;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
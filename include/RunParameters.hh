@@ -0,0 +1,96 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/include/RunParameters.hh
+/// \brief Definition of the RunParameters class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef RunParameters_h
+#define RunParameters_h 1
+
+#include "globals.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+// direction of the primary particle
+enum class SourceDirection : G4int
+{
+  Isotropic = 0,  // over 4 pi, or towards the Tank with /opnovice2/gun/biasCone
+  Beam            // along -z
+};
+
+// The source parameters of a run. The master publishes them before
+// BeamOn (main() for the position scans, /opnovice2/run/ otherwise); each
+// thread copies the published block once, in RunAction::BeginOfRunAction(),
+// and only reads its own copy during the events.
+// A scan runs all its points in a single BeamOn: event i belongs to point
+// i / eventsPerPoint, so the run manager spreads the points over all the
+// workers and Run keeps a tally per point.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class RunParameters
+{
+ public:
+  G4ThreeVector sourceOrigin = G4ThreeVector(10. * mm, 0., 0.);
+  G4double sourceEnergy = -1.;  // < 0: the energy of the selected source
+  SourceDirection sourceDirection = SourceDirection::Isotropic;
+
+  // source origins of the scan points; empty if there is no scan
+  std::vector<G4ThreeVector> scanOrigins;
+  G4int eventsPerPoint = 1;
+
+  // process of a farm (OpNovice2 --shard): Run writes the sums of its
+  // tallies instead of the usual line, for FarmDriver to merge
+  G4bool farmShard = false;
+
+  G4int GetNScanPoints() const { return static_cast<G4int>(scanOrigins.size()); }
+  // -1 if the event is not part of a scan
+  G4int GetScanPoint(G4int eventID) const
+  {
+    const G4int point = eventID / eventsPerPoint;
+    return point < GetNScanPoints() ? point : -1;
+  }
+  const G4ThreeVector& GetSourceOrigin(G4int eventID) const
+  {
+    const G4int point = GetScanPoint(eventID);
+    return point < 0 ? sourceOrigin : scanOrigins[point];
+  }
+
+  // the block used by the next runs; master thread only
+  static void Publish(const RunParameters& params);
+  // a copy of the last published block
+  static RunParameters GetPublished();
+
+  void Print() const;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*RunParameters_h*/
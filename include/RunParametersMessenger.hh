@@ -0,0 +1,70 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/include/RunParametersMessenger.hh
+/// \brief Definition of the RunParametersMessenger class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef RunParametersMessenger_h
+#define RunParametersMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class G4UIdirectory;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+// /opnovice2/run/: edits the published RunParameters. Master only, the
+// workers pick the parameters up at the start of the next run.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class RunParametersMessenger : public G4UImessenger
+{
+ public:
+  RunParametersMessenger();
+  ~RunParametersMessenger() override;
+
+  void SetNewValue(G4UIcommand*, G4String) override;
+
+ private:
+  G4UIdirectory* fRunDir = nullptr;
+  G4UIcmdWith3VectorAndUnit* fOriginCmd = nullptr;
+  G4UIcmdWithADoubleAndUnit* fEnergyCmd = nullptr;
+  G4UIcmdWithAString* fDirectionCmd = nullptr;
+  G4UIcmdWith3VectorAndUnit* fScanPointCmd = nullptr;
+  G4UIcmdWithAnInteger* fEventsPerPointCmd = nullptr;
+  G4UIcmdWithoutParameter* fScanClearCmd = nullptr;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*RunParametersMessenger_h*/
@@ -0,0 +1,117 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/include/StackingAction.hh
+/// \brief Definition of the StackingAction class
+//
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef StackingAction_h
+#define StackingAction_h 1
+
+#include "globals.hh"
+#include "G4MaterialPropertyVector.hh"
+#include "G4UserStackingAction.hh"
+#include "OpticalStack.hh"
+
+class Run;
+class StackingMessenger;
+class StepContext;
+class TrackInformation;
+
+// what to do with the optical photons once they have been counted
+enum class PhotonStackPolicy : G4int
+{
+  Track = 0,  // push them to the urgent stack (default)
+  Kill,       // only count them
+  Defer       // push them to the waiting stack
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class StackingAction : public G4UserStackingAction
+{
+ public:
+  explicit StackingAction(StepContext* context);
+  ~StackingAction() override;
+
+  // Counts each new Cerenkov/scintillation photon once, when it is stacked
+  // (Run::AddScintillation etc., histograms 1-3), then applies the policy.
+  // In the fast optical mode, scintillation photons inside the light map
+  // are killed after sampling their detection from the map.
+  // Scintillation photons of a material with /opnovice2/scintFraction f
+  // get the weight 1/f. With /opnovice2/gun/biasCone, the products of a radioactive decay are
+  // redirected towards the Tank and weighted first. The counted photons
+  // created after the time gate are killed, and with a quantum
+  // efficiency curve the others are cut to its band.
+  G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track*) override;
+
+  inline void SetPhotonPolicy(PhotonStackPolicy val) { fPhotonPolicy = val; }
+  inline PhotonStackPolicy GetPhotonPolicy() const { return fPhotonPolicy; }
+
+  // number of scintillation photons per thread and run that are also
+  // traced by the standalone OpticalStack, for its validation
+  inline void SetRayTraceSamples(G4int val) { fRayTraceSamples = val; }
+
+  // spectral acceptance of the Tank readout; takes ownership, nullptr
+  // removes it
+  void SetQuantumEfficiency(G4MaterialPropertyVector* qe);
+
+ private:
+  void BiasDecayProduct(const G4Track*) const;
+  void SampleForRayTrace(const G4Track*, Run* run);
+  // true, and counted, if the time is past the gate of the run
+  G4bool IsOutOfGate(G4double time, G4double weight, Run* run) const;
+  // false if the photon is cut; the weight of the survivors is updated
+  G4bool AcceptSpectrum(const G4Track*, TrackInformation* info,
+                        G4double& weight, Run* run);
+
+  StackingMessenger* fStackingMessenger = nullptr;
+
+  PhotonStackPolicy fPhotonPolicy = PhotonStackPolicy::Track;
+
+  // per-thread run state, owned by RunAction
+  StepContext* fContext = nullptr;
+
+  // ray tracer validation; the stack is rebuilt for each run
+  G4int fRayTraceSamples = 0;
+  G4int fRayTraced = 0;
+  G4int fRayTraceRunID = -1;
+  OpticalStack fOpticalStack;
+  PhotonBatch fPhotonBatch;
+
+  // quantum efficiency curve and its peak; checked against the materials
+  // at the first photon of each run
+  G4MaterialPropertyVector* fQE = nullptr;
+  G4double fQEPeak = 0.;
+  G4bool fQEActive = false;
+  G4int fQERunID = -1;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*StackingAction_h*/
@@ -0,0 +1,128 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/include/StepBenchmark.hh
+/// \brief Definition of the StepBenchmark class
+//
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef StepBenchmark_h
+#define StepBenchmark_h 1
+
+#include "globals.hh"
+#include "G4OpBoundaryProcess.hh"
+#include "G4TrackStatus.hh"
+#include "TrackInformation.hh"
+
+#include <array>
+#include <vector>
+
+class DetectorConstruction;
+class SteppingAction;
+class G4ParticleDefinition;
+class G4Step;
+class G4Track;
+
+// Micro-benchmark of the stepping hot path. While recording, copies of the
+// steps seen by SteppingAction are kept, up to a maximum per branch. At the
+// end of the run they are replayed in a tight loop through the same user
+// code (SteppingAction::ProcessStep, TankSD) into a scratch Run, and the
+// cost per step of each branch is printed.
+//
+// Only code that can run on a detached G4Step is covered: the tracking
+// action and SteppingVerbose need the live tracking/stepping managers.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class StepBenchmark
+{
+ public:
+  enum Branch
+  {
+    kOpticalBoundary = 0,  // optical photon, step ends on a boundary
+    kOpticalWLS,           // optical photon absorbed by OpWLS/OpWLS2
+    kOpticalBulk,          // any other optical photon step
+    kChargedSecondaries,   // charged particle step with secondaries
+    kTankEntry,            // alpha/beta/gamma first step in the Tank
+    kNBranches
+  };
+
+  StepBenchmark(SteppingAction* stepping, DetectorConstruction* detector);
+  ~StepBenchmark();
+
+  // number of steps recorded per branch; 0 disables the benchmark
+  void SetMaxSteps(G4int val) { fMaxSteps = val > 0 ? val : 0; }
+  G4int GetMaxSteps() const { return fMaxSteps; }
+  void SetRepetitions(G4int val) { fRepetitions = val > 0 ? val : 1; }
+
+  inline G4bool IsRecording() const { return fMaxSteps > 0 && !fFull; }
+
+  // copy the step (before the user code has modified the track) if its
+  // branch is not full yet
+  void Record(const G4Step* step);
+
+  // time the recorded steps, print the result and drop them
+  void Replay();
+  void Clear();
+
+ private:
+  struct RecordedStep
+  {
+    G4Step* step = nullptr;
+    G4Track* track = nullptr;
+    std::vector<G4Track*> secondaries;
+    // state the user code modifies, restored before each call
+    TrackInformation info;
+    G4int reflectionNumber = 0;
+    G4TrackStatus status = fAlive;
+    // the boundary process has moved on by the time of the replay
+    G4OpBoundaryProcessStatus boundaryStatus = Undefined;
+  };
+
+  G4int Classify(const G4Step* step) const;
+  void Restore(RecordedStep& rec) const;
+  static const char* GetBranchName(G4int branch);
+
+  SteppingAction* fSteppingAction = nullptr;
+  DetectorConstruction* fDetector = nullptr;
+
+  G4int fMaxSteps = 0;
+  G4int fRepetitions = 100;
+  G4bool fFull = false;
+
+  const G4ParticleDefinition* fOpticalPhoton = nullptr;
+  const G4ParticleDefinition* fAlpha = nullptr;
+  const G4ParticleDefinition* fElectron = nullptr;
+  const G4ParticleDefinition* fPositron = nullptr;
+  const G4ParticleDefinition* fGamma = nullptr;
+
+  std::array<std::vector<RecordedStep>, kNBranches> fSteps;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*StepBenchmark_h*/
@@ -0,0 +1,138 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/include/StepContext.hh
+/// \brief Definition of the StepContext class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef StepContext_h
+#define StepContext_h 1
+
+#include "globals.hh"
+#include "G4AnalysisManager.hh"
+
+#include <vector>
+
+class DetectorConstruction;
+class DirectionBias;
+class LightMap;
+class Run;
+class G4Cerenkov;
+class G4OpBoundaryProcess;
+class G4ParticleDefinition;
+class G4Scintillation;
+class G4VPhysicalVolume;
+class G4VProcess;
+
+// Per-thread cache of everything the user actions look up while tracking:
+// the current Run, the analysis manager and its active H1 flags, the
+// particle definitions, the optical processes and the main volumes.
+// One instance per worker, owned by RunAction; it is filled in
+// RunAction::BeginOfRunAction() and cleared in EndOfRunAction(), so the
+// stepping and stacking actions do no singleton or table lookups per step.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class StepContext
+{
+ public:
+  explicit StepContext(DetectorConstruction* detector);
+  ~StepContext() = default;
+
+  void BeginOfRun(Run* run);
+  void EndOfRun();
+
+  G4bool IsValid() const { return fRun != nullptr; }
+
+  Run* GetRun() const { return fRun; }
+  G4AnalysisManager* GetAnalysisManager() const { return fAnalysisManager; }
+  // histograms filled for this run; see HistoManager::Book()
+  G4bool IsH1Active(G4int id) const
+  {
+    return id >= 0 && static_cast<std::size_t>(id) < fH1Active.size()
+           && fH1Active[id];
+  }
+
+  const G4ParticleDefinition* GetOpticalPhoton() const { return fOpticalPhoton; }
+  const G4ParticleDefinition* GetElectron() const { return fElectron; }
+  const G4ParticleDefinition* GetGamma() const { return fGamma; }
+  const G4ParticleDefinition* GetAlpha() const { return fAlpha; }
+
+  const G4VProcess* GetAbsorptionProcess() const { return fAbsorptionProcess; }
+  const G4VProcess* GetRayleighProcess() const { return fRayleighProcess; }
+  const G4VProcess* GetWLSProcess() const { return fWLSProcess; }
+  const G4VProcess* GetWLS2Process() const { return fWLS2Process; }
+  G4OpBoundaryProcess* GetBoundaryProcess() const { return fBoundaryProcess; }
+  G4Scintillation* GetScintProcess() const { return fScintProcess; }
+  G4Cerenkov* GetCerenkovProcess() const { return fCerenkovProcess; }
+
+  // map sampled instead of tracking scintillation photons, if loaded
+  void SetLightMap(const LightMap* map) { fLightMap = map; }
+  const LightMap* GetLightMap() const { return fLightMap; }
+
+  // source biasing applied to radioactive decay products, if enabled
+  void SetDirectionBias(const DirectionBias* bias) { fDirectionBias = bias; }
+  const DirectionBias* GetDirectionBias() const { return fDirectionBias; }
+
+  // optical photons later than this are killed; 0 if there is no gate
+  void SetTimeGate(G4double val) { fTimeGate = val; }
+  G4double GetTimeGate() const { return fTimeGate; }
+
+  DetectorConstruction* GetDetector() const { return fDetector; }
+  const G4VPhysicalVolume* GetWorldVolume() const { return fWorldVolume; }
+  const G4VPhysicalVolume* GetTankVolume() const { return fTankVolume; }
+
+ private:
+  DetectorConstruction* fDetector = nullptr;
+
+  Run* fRun = nullptr;
+  G4AnalysisManager* fAnalysisManager = nullptr;
+  std::vector<G4bool> fH1Active;
+
+  const G4ParticleDefinition* fOpticalPhoton = nullptr;
+  const G4ParticleDefinition* fElectron = nullptr;
+  const G4ParticleDefinition* fGamma = nullptr;
+  const G4ParticleDefinition* fAlpha = nullptr;
+
+  const G4VProcess* fAbsorptionProcess = nullptr;
+  const G4VProcess* fRayleighProcess = nullptr;
+  const G4VProcess* fWLSProcess = nullptr;
+  const G4VProcess* fWLS2Process = nullptr;
+  G4OpBoundaryProcess* fBoundaryProcess = nullptr;
+  G4Scintillation* fScintProcess = nullptr;
+  G4Cerenkov* fCerenkovProcess = nullptr;
+
+  const G4VPhysicalVolume* fWorldVolume = nullptr;
+  const G4VPhysicalVolume* fTankVolume = nullptr;
+
+  const LightMap* fLightMap = nullptr;
+  const DirectionBias* fDirectionBias = nullptr;
+  G4double fTimeGate = 0.;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*StepContext_h*/
@@ -35,33 +35,163 @@
 #include "globals.hh"
 #include "G4UserSteppingAction.hh"
 #include "DetectorConstruction.hh"
+#include "RoiEnvelope.hh"
+#include "Run.hh"
+
+#include <array>
+#include <map>
+#include <vector>
 
 class DetectorConstruction;
 class SteppingMessenger;
+class StepBenchmark;
+class StepContext;
+class TrackInformation;
+class G4Cerenkov;
+class G4ParticleDefinition;
+class G4OpBoundaryProcess;
+class G4Scintillation;
+class G4VProcess;
+
+// how often the optical photon group velocity is checked against GROUPVEL
+enum class GroupVelocityCheck : G4int
+{
+	Off = 0,
+	Sampled,  // one optical step in N
+	Always
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 class SteppingAction : public G4UserSteppingAction
 {
 public:
-	SteppingAction(DetectorConstruction* detector);
+	SteppingAction(DetectorConstruction* detector, StepContext* context);
 	~SteppingAction() override;
 
 	// method from the base class
 	void UserSteppingAction(const G4Step*) override;
 
-	inline G4int GetGammaCount() const { return gammaCount; }
-	void ResetGammaCount() { gammaCount = 0; }
+	// pick up the process handles and histogram flags from the StepContext;
+	// called from RunAction::BeginOfRunAction() after it has been filled
+	void BeginOfRun();
+	// called from RunAction::EndOfRunAction() after the output is written
+	void EndOfRun();
+
+	// the dispatch done for each step, also used to replay recorded steps
+	void ProcessStep(const G4Step* step, Run* run);
+
+	StepBenchmark* GetBenchmark() const { return fBenchmark; }
+
+	// status of the optical boundary process for the current step; while
+	// recorded steps are replayed, the recorded status is used instead
+	G4OpBoundaryProcessStatus GetBoundaryStatus() const;
+	inline void SetReplayBoundaryStatus(const G4OpBoundaryProcessStatus* status) { fReplayBoundaryStatus = status; }
 
 	inline void SetKillOnSecondSurface(G4bool val) { fKillOnSecondSurface = val; }
 	inline G4bool GetKillOnSecondSurface() { return fKillOnSecondSurface; }
 
+	inline void SetGroupVelocityCheck(GroupVelocityCheck val) { fGroupVelocityCheck = val; }
+	inline GroupVelocityCheck GetGroupVelocityCheck() const { return fGroupVelocityCheck; }
+	inline void SetGroupVelocitySampling(G4int val) { fGroupVelocitySampling = val > 0 ? val : 1; }
+	inline void SetGroupVelocityFatal(G4bool val) { fGroupVelocityFatal = val; }
+
+	// optical bookkeeping compiled into the handler chosen at BeginOfRun():
+	// boundary and bulk process statistics, WLS/WLS2 statistics, and the
+	// histograms 4-26. With all three off only the detected photons are
+	// counted.
+	inline void SetBoundaryStats(G4bool val) { fBoundaryStats = val; }
+	inline void SetWLSStats(G4bool val) { fWLSStats = val; }
+	inline void SetHistograms(G4bool val) { fHistograms = val; }
+
+	// optical weight window: importance per logical volume name, resolved
+	// at BeginOfRun(); volumes not listed have importance 1
+	inline void SetWeightWindow(G4bool val) { fWeightWindow = val; }
+	inline void SetImportance(const G4String& volume, G4double val) { fImportanceByName[volume] = val; }
+
+	// optical photons later than the gate are killed, here and when they
+	// are stacked; 0 disables it. Passed to StackingAction at BeginOfRun().
+	inline void SetTimeGate(G4double val) { fTimeGate = val; }
+
+	// region-of-interest envelope, built from the world at BeginOfRun()
+	RoiEnvelope& GetRoiEnvelope() { return fRoi; }
+
+	inline void SetVerbose(G4int val) { fVerbose = val; }
+	inline G4int GetVerbose() const { return fVerbose; }
+
 private:
+	// true when the step crosses from outside into a Tank-role volume
+	G4bool EntersTank(const G4Step* step) const;
+
+	// per-particle stepping handlers, dispatched through a table indexed by
+	// G4ParticleDefinition::GetInstanceID() that is filled in BeginOfRun()
+	using StepHandler = void (SteppingAction::*)(const G4Step*, Run*);
+	void RegisterHandler(const G4ParticleDefinition* particle, StepHandler handler);
+
+	template <G4bool kBoundaryStats, G4bool kWLSStats, G4bool kHistos>
+	void HandleOptical(const G4Step* step, Run* run);
+	StepHandler SelectOpticalHandler() const;
+	void HandleDefault(const G4Step* step, Run* run);
+
+	void CheckGroupVelocity(const G4Step* step, Run* run);
+	// roulette or split the photon when it crosses into a volume of
+	// different importance
+	void ApplyWeightWindow(const G4Step* step, TrackInformation* trackInfo);
+	// stop the track if it escapes the ROI envelope through the world
+	void KillOutsideRoi(const G4Step* step, Run* run) const;
+
+	std::vector<StepHandler> fHandlers;
+
 	SteppingMessenger* fSteppingMessenger = nullptr;
+	StepBenchmark* fBenchmark = nullptr;
 
-	G4int gammaCount = 0;  //JEgϐ
 	G4int fVerbose = 0;
 	size_t fIdxVelocity = 0;
 
 	G4bool fKillOnSecondSurface = false;
+	G4bool fBoundaryStats = true;
+	G4bool fWLSStats = true;
+	G4bool fHistograms = true;
+
+	GroupVelocityCheck fGroupVelocityCheck = GroupVelocityCheck::Off;
+	G4int fGroupVelocitySampling = 1000;
+	G4long fGroupVelocityStepCount = 0;
+	G4bool fGroupVelocityFatal = false;
+
+	G4bool fWeightWindow = false;
+	std::map<G4String, G4double> fImportanceByName;
+	std::vector<G4double> fImportance;  // by logical volume instance ID
+	G4TrackVector* fSecondaries = nullptr;  // of the step being processed
+
+	G4double fTimeGate = 0.;
+
+	RoiEnvelope fRoi;
+	G4bool fRoiActive = false;  // enabled and built for this run
+	const G4VPhysicalVolume* fWorldVolume = nullptr;
+
+	// per-thread run state, owned by RunAction
+	StepContext* fContext = nullptr;
+
+	// process handles of this thread, copied from fContext once per run
+	const G4VProcess* fAbsorptionProcess = nullptr;
+	const G4VProcess* fRayleighProcess = nullptr;
+	const G4VProcess* fWLSProcess = nullptr;
+	const G4VProcess* fWLS2Process = nullptr;
+	G4OpBoundaryProcess* fBoundaryProcess = nullptr;
+	G4Scintillation* fScintProcess = nullptr;
+	G4Cerenkov* fCerenkovProcess = nullptr;
+	const G4OpBoundaryProcessStatus* fReplayBoundaryStatus = nullptr;
+
+	// histograms filled for each boundary status; only the histograms that
+	// are active for this run are kept, so that the incidence angle is only
+	// computed when something will record it
+	struct BoundaryHistos
+	{
+		G4int angle[2] = { -1, -1 };
+		G4bool direction = false;
+	};
+	std::array<BoundaryHistos, Run::kNBoundaryStatus> fBoundaryHistos{};
+
 	DetectorConstruction* fDetector = nullptr;  // ǉ: `fDetector` o[ϐƂĐ錾
 };
 
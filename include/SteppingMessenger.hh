@@ -39,6 +39,10 @@
 class SteppingAction;
 class G4UIdirectory;
 class G4UIcmdWithABool;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithAString;
+class G4UIcommand;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -53,6 +57,22 @@ class SteppingMessenger : public G4UImessenger
  private:
   G4UIdirectory* fSteppingDir = nullptr;
   G4UIcmdWithABool* fKillOnSecondSurfaceCmd = nullptr;
+  G4UIcmdWithABool* fBoundaryStatsCmd = nullptr;
+  G4UIcmdWithABool* fWLSStatsCmd = nullptr;
+  G4UIcmdWithABool* fHistogramsCmd = nullptr;
+  G4UIcmdWithAnInteger* fVerboseCmd = nullptr;
+  G4UIcmdWithAnInteger* fBenchmarkCmd = nullptr;
+  G4UIcmdWithAnInteger* fBenchmarkRepeatCmd = nullptr;
+  G4UIcmdWithAString* fGroupVelocityCheckCmd = nullptr;
+  G4UIcmdWithAnInteger* fGroupVelocitySamplingCmd = nullptr;
+  G4UIcmdWithABool* fGroupVelocityFatalCmd = nullptr;
+  G4UIcmdWithABool* fWeightWindowCmd = nullptr;
+  G4UIcommand* fImportanceCmd = nullptr;
+  G4UIcmdWithADoubleAndUnit* fTimeGateCmd = nullptr;
+  G4UIdirectory* fRoiDir = nullptr;
+  G4UIcmdWithABool* fRoiEnableCmd = nullptr;
+  G4UIcmdWithADoubleAndUnit* fRoiMarginCmd = nullptr;
+  G4UIcommand* fRoiKillCmd = nullptr;
   SteppingAction* fSteppingAction = nullptr;
 };
 
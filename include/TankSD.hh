@@ -0,0 +1,78 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/include/TankSD.hh
+/// \brief Definition of the TankSD class
+//
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifndef TankSD_h
+#define TankSD_h 1
+
+#include "G4THitsMap.hh"
+#include "G4VSensitiveDetector.hh"
+
+#include <array>
+
+class G4ParticleDefinition;
+
+// Counts the alpha, beta (e-/e+) and gamma tracks entering the Tank.
+// Attached to the Tank logical volume, so it is only called for steps
+// inside the Tank; an entry is the first step whose pre-step point lies on
+// the Tank boundary. One hits map per species, keyed by copy number.
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+class TankSD : public G4VSensitiveDetector
+{
+ public:
+  enum Species
+  {
+    kAlpha = 0,
+    kBeta,
+    kGamma,
+    kNSpecies
+  };
+
+  explicit TankSD(const G4String& name);
+  ~TankSD() override = default;
+
+  void Initialize(G4HCofThisEvent*) override;
+  G4bool ProcessHits(G4Step*, G4TouchableHistory*) override;
+
+ private:
+  std::array<G4THitsMap<G4double>*, kNSpecies> fHitsMaps{};
+
+  const G4ParticleDefinition* fAlpha = nullptr;
+  const G4ParticleDefinition* fElectron = nullptr;
+  const G4ParticleDefinition* fPositron = nullptr;
+  const G4ParticleDefinition* fGamma = nullptr;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif /*TankSD_h*/
@@ -59,10 +59,24 @@ class TrackInformation : public G4VUserTrackInformation
 
   inline G4int GetReflectionNumber() const { return fReflectionNumber; }
   inline void IncrementReflectionNumber() { ++fReflectionNumber; }
+  inline void SetReflectionNumber(G4int n) { fReflectionNumber = n; }
+
+  // statistical weight, inherited by the secondaries; set by the source
+  // biasing (DirectionBias) and changed by the optical weight window
+  // (SteppingAction)
+  inline G4double GetWeight() const { return fWeight; }
+  inline void SetWeight(G4double w) { fWeight = w; }
+
+  // a copy of a photon split by the weight window: it carries part of the
+  // weight of its photon and is always tracked (StackingAction)
+  inline G4bool IsSplitCopy() const { return fSplitCopy; }
+  inline void SetSplitCopy(G4bool b) { fSplitCopy = b; }
 
  private:
   G4bool fFirstTankX = false;
+  G4bool fSplitCopy = false;
   G4int fReflectionNumber = 0;
+  G4double fWeight = 1.;
 };
 
 extern G4ThreadLocal G4Allocator<TrackInformation>* aTrackInformationAllocator;
@@ -31,25 +31,15 @@
 #include "PrimaryGeneratorAction.hh"
 #include "DetectorConstruction.hh"
 #include "RunAction.hh"
+#include "StackingAction.hh"
+#include "StepContext.hh"
 #include "SteppingAction.hh"
 #include "TrackingAction.hh"
 
-// setter / getter ̎
-void ActionInitialization::SetPrimaryGenerator(PrimaryGeneratorAction* pg)
-{
-	fPrimaryGenerator = pg;
-}
-
-PrimaryGeneratorAction* ActionInitialization::GetPrimaryGenerator() const
-{
-	return fPrimaryGenerator;
-}
-
 ActionInitialization::ActionInitialization(DetectorConstruction* detector, const G4String& outputFileName)
 	: G4VUserActionInitialization(),
 	fDetector(detector),
-	fOutputFileName(outputFileName),
-	fPrimaryGenerator(nullptr) // nullptr
+	fOutputFileName(outputFileName)
 {}
 
 void ActionInitialization::SetOutputFileName(const G4String& fname)
@@ -60,34 +50,33 @@ void ActionInitialization::SetOutputFileName(const G4String& fname)
 void ActionInitialization::BuildForMaster() const
 {
 	// }X^[pɂ́AKvɉďo̓t@Cn RunAction 𐶐
-	SetUserAction(new RunAction(fOutputFileName));
+	SetUserAction(new RunAction(fDetector, fOutputFileName));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void ActionInitialization::Build() const
 {
-	// łɊOPrimaryGeneratorActionZbgĂ邩ǂmFA
-	// ZbgĂȂΓŐ
-	if (!fPrimaryGenerator)
-	{
-		fPrimaryGenerator = new PrimaryGeneratorAction();
-	}
-
 	// vC}
 	auto primary = new PrimaryGeneratorAction();
 	SetUserAction(primary);
 
+	// per-thread run state shared by the actions below, owned by RunAction
+	auto context = new StepContext(fDetector);
+
 	// XebsOANV̐Ɠo^
-	auto steppingAction = new SteppingAction(fDetector);
+	auto steppingAction = new SteppingAction(fDetector, context);
 	SetUserAction(steppingAction);
 
 	// ANV
-	auto runAction = new RunAction(primary, steppingAction, fOutputFileName);
+	auto runAction = new RunAction(primary, steppingAction, context, fOutputFileName);
 	SetUserAction(runAction);
 
 	// TrackingAction̓o^
 	SetUserAction(new TrackingAction);
+
+	// created optical photons are counted when they are stacked
+	SetUserAction(new StackingAction(context));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -30,7 +30,9 @@
 
 #include "DetectorConstruction.hh"
 #include "DetectorMessenger.hh"
+#include "TankSD.hh"
 #include "G4NistManager.hh"
+#include "G4OpticalParameters.hh"
 #include "G4Material.hh"
 #include "G4Element.hh"
 #include "G4LogicalBorderSurface.hh"
@@ -40,11 +42,14 @@
 #include "G4LogicalVolume.hh"
 #include "G4ThreeVector.hh"
 #include "G4PVPlacement.hh"
+#include "G4SDManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4GenericTrap.hh"
 #include "G4SubtractionSolid.hh"
 #include "G4Tubs.hh"
 
+#include <cmath>
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 //[hؑւ
 //#define SCINTILLATOR
@@ -211,6 +216,8 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	auto world_box = new G4Box("World", fExpHall_x, fExpHall_y, fExpHall_z);
 	fWorld_LV = new G4LogicalVolume(world_box, fWorldMaterial, "World");
 	G4VPhysicalVolume* world_PV = new G4PVPlacement(nullptr, G4ThreeVector(), fWorld_LV, "World", nullptr, false, 0);
+	fVolumeRoles.clear();
+	RegisterVolumeRole(fWorld_LV, VolumeRole::World);
 
 
 #ifdef SCINTILLATOR
@@ -218,21 +225,26 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	auto Ring_Box = new G4Box("Tank_ZnS", fTankRZnSout_x, fTankRZnSout_y, fTankRZnSout_z);
 	RingBox_LV = new G4LogicalVolume(Ring_Box, fTankMaterialR, "RingBox_ZnSLV");
 	RingBox = new G4PVPlacement(0, G4ThreeVector(0, 0, -fTankRZnSout_z * mm), RingBox_LV, "RingBox_ZnSLV", fWorld_LV, false, 0);
+	RegisterVolumeRole(RingBox_LV, VolumeRole::Reflector);
 
 	// The tank2 (ZnS)
 	auto tank_box2 = new G4Box("Tank_ZnS", fTank2_x, fTank2_y, fTank2_z);
 	fTank2_LV = new G4LogicalVolume(tank_box2, fTankMaterial2, "Tank_ZnS");
 	fTank2 = new G4PVPlacement(0, G4ThreeVector(0, 0, -height_ZnS * mm), fTank2_LV, "Tank_ZnS", fWorld_LV, false, 0);
+	RegisterVolumeRole(fTank2_LV, VolumeRole::Scintillator);
 
 	// The tankPET
 	auto tank_boxPET = new G4Box("Tank_ZnS", fTankPET_x, fTankPET_y, fTankPET_z);
 	fTankPET_LV = new G4LogicalVolume(tank_boxPET, fTankMaterialPET, "Tank_PET");
 	fTankPET = new G4PVPlacement(0, G4ThreeVector(0, 0, -height_PET * mm), fTankPET_LV, "Tank_PET", fWorld_LV, false, 0);
+	// transparent substrate of the ZnS film: the light only passes through
+	RegisterVolumeRole(fTankPET_LV, VolumeRole::Guide);
 
 	// The tank3 (Plastic)
 	auto tank_box3 = new G4Box("Tank_Plastic", fTank3_x, fTank3_y, fTank3_z);
 	fTank3_LV = new G4LogicalVolume(tank_box3, fTankMaterial3, "Tank_Plastic");
 	fTank3 = new G4PVPlacement(0, G4ThreeVector(0, 0, -height_Plastic * mm), fTank3_LV, "Tank_Plastic", fWorld_LV, false, 0);
+	RegisterVolumeRole(fTank3_LV, VolumeRole::Scintillator);
 
 	/*
 	//GSOP[X
@@ -263,6 +275,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	for (const auto& pos : holePositions) {
 		new G4PVPlacement(0, pos, fTank4_LV, "Tank_GSO", fWorld_LV, false, 0);
 	}
+	RegisterVolumeRole(fTank4_LV, VolumeRole::Scintillator);
 
 	// Reflector_GSO
 	auto fTankRGSOout = new G4Box("GSOOutBox", fTankRGSOout_x, fTankRGSOout_y, fTankRGSOout_z);
@@ -270,6 +283,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	auto GSORing_Box = new G4SubtractionSolid("GSORing_Box", fTankRGSOout, fTankRGSOin);
 	GSORingBox_LV = new G4LogicalVolume(GSORing_Box, fTankMaterialR, "GSORingBox_LV");
 	GSORingBox = new G4PVPlacement(0, G4ThreeVector(0, 0, -height_Ref_GSO * mm), GSORingBox_LV, "GSORingBox_LV", fWorld_LV, false, 0);
+	RegisterVolumeRole(GSORingBox_LV, VolumeRole::Reflector);
 
 	// Grease
 	// OXw̃TCY`
@@ -308,14 +322,19 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
 	G4LogicalVolume* GreaseGSOx_LV = new G4LogicalVolume(GreaseGridUnion, fTankMaterialGr, "GreaseGSO_LV");
 	new G4PVPlacement(0, G4ThreeVector(0, 0, -height_GSO * mm), GreaseGSOx_LV, "GreaseGridUnion_x", fWorld_LV, false, 0);
+	RegisterVolumeRole(GreaseGSOx_LV, VolumeRole::Grease);
 
 	auto Grease = new G4Box("Grease", fTank3_x + 0.01, fTank3_y + 0.01, Greese_z);
 	Grease_LV = new G4LogicalVolume(Grease, fTankMaterialGr, "Grease_LV");
 	Grease_LV2 = new G4LogicalVolume(Grease, fTankMaterialGr, "Grease_LV");
+	RegisterVolumeRole(Grease_LV, VolumeRole::Grease);
+	RegisterVolumeRole(Grease_LV2, VolumeRole::Grease);
 
 	//GSOObh
 	GreaseGSOx_LV = new G4LogicalVolume(GreaseGrid_x, fTankMaterialR, "GreaseGSO_LV");
 	GreaseGSOy_LV = new G4LogicalVolume(GreaseGrid_y, fTankMaterialR, "GreaseGSO_LV");
+	RegisterVolumeRole(GreaseGSOx_LV, VolumeRole::Reflector);
+	RegisterVolumeRole(GreaseGSOy_LV, VolumeRole::Reflector);
 
 	GreaseGSO_x1 = new G4PVPlacement(0, G4ThreeVector(0, (fTank4_yGap * 4), -height_GSO * mm), GreaseGSOx_LV, "GreaseGSO_x1", fWorld_LV, false, 0);
 	GreaseGSO_x2 = new G4PVPlacement(0, G4ThreeVector(0, (fTank4_yGap * 2), -height_GSO * mm), GreaseGSOx_LV, "GreaseGSO_x2", fWorld_LV, false, 0);
@@ -353,6 +372,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	auto tank_boxG = new G4GenericTrap("Tank_Guide", GuideLength / 2, vertices);
 	fTankG_LV = new G4LogicalVolume(tank_boxG, fTankMaterialG, "Tank_Guide");
 	fTankG = new G4PVPlacement(0, G4ThreeVector(0, 0, -height_Guide * mm), fTankG_LV, "Tank_Guide", fWorld_LV, false, 0);
+	RegisterVolumeRole(fTankG_LV, VolumeRole::Guide);
 
 	// Guide_Reflector
 	G4double bottomXRefOut = bottomX + 0.4 * mm;
@@ -391,12 +411,14 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	auto RefPlastic = new G4SubtractionSolid("RefPlastic", reflectorOut, reflectorIn);
 	reflector_LV = new G4LogicalVolume(RefPlastic, fTankMaterialR, "ReflectorPla");
 	fTankRPla = new G4PVPlacement(0, G4ThreeVector(0, 0, -(height_Guide + 0.005) * mm), reflector_LV, "ReflectorPla", fWorld_LV, false, 0);
+	RegisterVolumeRole(reflector_LV, VolumeRole::Reflector);
 
 
 	// Grease_Guide_Detector
 	auto Grease2 = new G4Box("Grease", bottomX / 2, bottomY / 2, 0.005);
 	Grease_LV3 = new G4LogicalVolume(Grease2, fTankMaterialGr, "Grease_LV3");
 	GreaseGuideDET = new G4PVPlacement(0, G4ThreeVector(0, 0, -height_Gre_GuideDET * mm), Grease_LV3, "Grease_GSOGuide", fWorld_LV, false, 0);
+	RegisterVolumeRole(Grease_LV3, VolumeRole::Grease);
 
 	// Detector
 	G4double innerRadius = 0.0 * mm;
@@ -408,6 +430,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	auto tank_box = new G4Tubs("Tank", innerRadius, outerRadius, height, startAngle, spanningAngle);
 	fTank_LV = new G4LogicalVolume(tank_box, fTankMaterial, "Tank");
 	fTank = new G4PVPlacement(0, G4ThreeVector(0, 0, -height_DET * mm), fTank_LV, "Tank", fWorld_LV, false, 0);
+	RegisterVolumeRole(fTank_LV, VolumeRole::Tank);
 
 	/*
 	// Reflector_Detector
@@ -448,6 +471,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	auto foil_tube2 = new G4Tubs("AluminumFoil", 0, foil2_r, foil2_z / 2, 0.0 * deg, 360.0 * deg);  	// A~jẺ~`
 	auto foil_LV2 = new G4LogicalVolume(foil_tube2, aluminum2, "AluminumFoil");  	// ̃WJ{[
 	new G4PVPlacement(0, G4ThreeVector(0, 0, sourceFoil_Z), foil_LV2, "AluminumFoil", fWorld_LV, false, 0);  	// zuiTank̏ʂɔzuj
+	RegisterVolumeRole(foil_LV2, VolumeRole::Foil);
 
 
 
@@ -483,6 +507,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
 	// zuʒu̒izuj
 	fTank = new G4PVPlacement(0, G4ThreeVector(0, 0, detector_Z * mm), fTank_LV, "Tank", fWorld_LV, false, 0);
+	RegisterVolumeRole(fTank_LV, VolumeRole::Tank);
 
 
 	////////////////////////////////////////////////////////////////////////////////////
@@ -513,6 +538,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	// ----- zuiDetector ̏ɔzuj -----
 	G4double frame2_Z = detector_Z + (tank_z / 2) + (frame2_z / 2);
 	new G4PVPlacement(0, G4ThreeVector(0, 0, frame2_Z), frame_LV2, "Frame", fWorld_LV, false, 0);
+	RegisterVolumeRole(frame_LV2, VolumeRole::Scintillator);
 #endif
 
 
@@ -545,6 +571,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
 	// ----- zu -----
 	new G4PVPlacement(0, G4ThreeVector(0, 0, aluminumFoil_Z), foil_LV, "AluminumFoil", fWorld_LV, false, 0);
+	RegisterVolumeRole(foil_LV, VolumeRole::Foil);
 
 	////////////////////////////////////////////////////////////////////////////////////
 	// t[ (ALPHA, BETA, GAMMA ̏ꍇzu)
@@ -578,6 +605,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	// ----- zuiA~̏ɔzuj -----
 	G4double frame_Z = aluminumFoil_Z + (foil_z / 2) + (frame_z / 2);  // C: foil_z / 2 ǉ
 	new G4PVPlacement(0, G4ThreeVector(0, 0, frame_Z), frame_LV, "Frame", fWorld_LV, false, 0);
+	RegisterVolumeRole(frame_LV, VolumeRole::Frame);
 
 #endif
 #endif
@@ -691,11 +719,40 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 		G4cout << "----- Detector -----" << G4endl;
 		fTankMaterial->GetMaterialPropertiesTable()->DumpTable();
 	}
+
+	// uniform-grid copies of the tables above, for the stepping code
+	BuildOpticalTables();
+	fOpticalTables.Dump(false);
 	G4cout << "---------- end of propertisTable ----------\n" << G4endl;
 
 	return world_PV;
 }
 
+void DetectorConstruction::ConstructSDandField()
+{
+	// Tank entries of alpha/beta/gamma are scored by a sensitive detector,
+	// so that only steps inside the Tank reach user code. The detector is
+	// kept across geometry rebuilds (one instance per thread).
+	G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+	G4VSensitiveDetector* tankSD = sdManager->FindSensitiveDetector("TankSD", false);
+	if (!tankSD)
+	{
+		tankSD = new TankSD("TankSD");
+		sdManager->AddNewDetector(tankSD);
+	}
+	SetSensitiveDetector(fTank_LV, tankSD);
+}
+
+void DetectorConstruction::RegisterVolumeRole(const G4LogicalVolume* lv, VolumeRole role)
+{
+	const auto id = static_cast<std::size_t>(lv->GetInstanceID());
+	if (id >= fVolumeRoles.size())
+	{
+		fVolumeRoles.resize(id + 1, VolumeRole::None);
+	}
+	fVolumeRoles[id] = role;
+}
+
 void DetectorConstruction::SetSurfaceSigmaAlpha(G4double v)
 {
 	fSurface->SetSigmaAlpha(v);
@@ -939,6 +996,77 @@ void DetectorConstruction::AddSurfaceMPVR(const G4String& prop,
 	G4cout << "............." << G4endl;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void DetectorConstruction::BuildOpticalTables()
+{
+	fOpticalTables.Build();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void DetectorConstruction::SetScintFraction(const G4String& material, G4double fraction)
+{
+	fScintFractions[material].fraction = fraction;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void DetectorConstruction::ApplyScintFractions()
+{
+	fScintWeights.assign(G4Material::GetNumberOfMaterials(), 1.);
+	for (auto& entry : fScintFractions)
+	{
+		ScintFraction& scint = entry.second;
+		G4Material* material = G4Material::GetMaterial(entry.first, false);
+		G4MaterialPropertiesTable* mpt =
+			material ? material->GetMaterialPropertiesTable() : nullptr;
+		if (!mpt || !mpt->ConstPropertyExists("SCINTILLATIONYIELD"))
+		{
+			G4ExceptionDescription ed;
+			ed << "Material " << entry.first << " has no SCINTILLATIONYIELD;"
+				<< " its scintillation fraction is ignored.";
+			G4Exception("DetectorConstruction::ApplyScintFractions", "OpNovice2_008",
+				JustWarning, ed);
+			continue;
+		}
+
+		// by particle type, the yields are the PROTONSCINTILLATIONYIELD, ...
+		// vectors, which are not scaled: the full yield is generated
+		G4double fraction = scint.fraction;
+		if (fraction != 1. && G4OpticalParameters::Instance()->GetScintByParticleType())
+		{
+			G4ExceptionDescription ed;
+			ed << "Scintillation is set by particle type; the scintillation fraction of "
+				<< entry.first << " is ignored.";
+			G4Exception("DetectorConstruction::ApplyScintFractions", "OpNovice2_011",
+				JustWarning, ed);
+			fraction = 1.;
+		}
+
+		// a value different from the one set here was set by the user
+		const G4double yield = mpt->GetConstProperty("SCINTILLATIONYIELD");
+		if (yield != scint.scaledYield) scint.yield = yield;
+		scint.scaledYield = fraction * scint.yield;
+		mpt->AddConstProperty("SCINTILLATIONYIELD", scint.scaledYield);
+
+		// the spread of the weighted photon number stays that of the full
+		// yield: sigma' sqrt(fN) / f = sigma sqrt(N)
+		if (mpt->ConstPropertyExists("RESOLUTIONSCALE"))
+		{
+			const G4double resolution = mpt->GetConstProperty("RESOLUTIONSCALE");
+			if (resolution != scint.scaledResolution) scint.resolution = resolution;
+			scint.scaledResolution = std::sqrt(fraction) * scint.resolution;
+			mpt->AddConstProperty("RESOLUTIONSCALE", scint.scaledResolution);
+		}
+
+		fScintWeights[material->GetIndex()] = 1. / fraction;
+		if (fraction != 1.)
+		{
+			G4cout << "Scintillation of " << entry.first << ": fraction "
+				<< fraction << ", yield " << scint.yield * MeV << " -> "
+				<< scint.scaledYield * MeV << " /MeV" << G4endl;
+		}
+	}
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 void DetectorConstruction::AddTankMPC(const G4String& prop, G4double v)
 {
@@ -353,6 +353,27 @@ DetectorMessenger::DetectorMessenger(DetectorConstruction* Det)
 	fWorldMaterialCmd->SetGuidance("Set material of world.");
 	fWorldMaterialCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 	fWorldMaterialCmd->SetToBeBroadcasted(false);
+
+	fScintFractionCmd = new G4UIcommand("/opnovice2/scintFraction", this);
+	fScintFractionCmd->SetGuidance("Generate only the fraction f of the scintillation");
+	fScintFractionCmd->SetGuidance("photons of a material, each with weight 1/f.");
+	fScintFractionCmd->SetGuidance("Applied to SCINTILLATIONYIELD and RESOLUTIONSCALE");
+	fScintFractionCmd->SetGuidance("at the start of each run; 1 restores the full yield.");
+	fScintFractionCmd->SetGuidance("Ignored when scintillation is set by particle type.");
+	auto materialParam = new G4UIparameter("material", 's', false);
+	fScintFractionCmd->SetParameter(materialParam);
+	auto fractionParam = new G4UIparameter("fraction", 'd', false);
+	fractionParam->SetParameterRange("fraction > 0 && fraction <= 1");
+	fScintFractionCmd->SetParameter(fractionParam);
+	fScintFractionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fScintFractionCmd->SetToBeBroadcasted(false);
+
+	fDumpOpticalTablesCmd =
+		new G4UIcmdWithoutParameter("/opnovice2/dumpOpticalTables", this);
+	fDumpOpticalTablesCmd->SetGuidance("Rebuild and print the uniform-grid optical property");
+	fDumpOpticalTablesCmd->SetGuidance("tables of all materials, with every bin.");
+	fDumpOpticalTablesCmd->AvailableForStates(G4State_Idle);
+	fDumpOpticalTablesCmd->SetToBeBroadcasted(false);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -400,6 +421,8 @@ DetectorMessenger::~DetectorMessenger()
 	delete fWorldMatPropVectorCmd;
 	delete fWorldMatPropConstCmd;
 	delete fWorldMaterialCmd;
+	delete fScintFractionCmd;
+	delete fDumpOpticalTablesCmd;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -1324,6 +1347,19 @@ void DetectorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
 	{
 		fDetector->SetWorldMaterial(newValue);
 	}
+	else if (command == fDumpOpticalTablesCmd)
+	{
+		fDetector->BuildOpticalTables();
+		fDetector->GetOpticalTables().Dump(true);
+	}
+	else if (command == fScintFractionCmd)
+	{
+		std::istringstream instring(newValue);
+		G4String material;
+		G4double fraction = 1.;
+		instring >> material >> fraction;
+		fDetector->SetScintFraction(material, fraction);
+	}
 
 
 	else if (command == fTankMaterialCmd)
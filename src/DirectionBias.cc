@@ -0,0 +1,132 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/src/DirectionBias.cc
+/// \brief Implementation of the DirectionBias class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "DirectionBias.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4Transform3D.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DirectionBias::SetFraction(G4double val)
+{
+  // f = 1 would leave directions outside the cone with zero density
+  fFraction = std::min(std::max(val, 0.), 0.999);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DirectionBias::SetTarget(const G4VPhysicalVolume* target)
+{
+  fHasTarget = target != nullptr;
+  if(!target) return;
+
+  G4ThreeVector lower, upper;
+  target->GetLogicalVolume()->GetSolid()->BoundingLimits(lower, upper);
+  const G4Transform3D toWorld(target->GetObjectRotationValue(),
+                              target->GetObjectTranslation());
+
+  const G4double big = std::numeric_limits<G4double>::max();
+  fLower.set(big, big, big);
+  fUpper.set(-big, -big, -big);
+  for(G4int i = 0; i < 8; ++i)
+  {
+    const HepGeom::Point3D<G4double> local((i & 1) ? upper.x() : lower.x(),
+                                           (i & 2) ? upper.y() : lower.y(),
+                                           (i & 4) ? upper.z() : lower.z());
+    const G4ThreeVector corner = toWorld * local;
+    fCorners[i] = corner;
+    fLower.set(std::min(fLower.x(), corner.x()), std::min(fLower.y(), corner.y()),
+               std::min(fLower.z(), corner.z()));
+    fUpper.set(std::max(fUpper.x(), corner.x()), std::max(fUpper.y(), corner.y()),
+               std::max(fUpper.z(), corner.z()));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool DirectionBias::GetCone(const G4ThreeVector& position,
+                              G4ThreeVector& axis, G4double& cosCone) const
+{
+  if(position.x() >= fLower.x() && position.x() <= fUpper.x() &&
+     position.y() >= fLower.y() && position.y() <= fUpper.y() &&
+     position.z() >= fLower.z() && position.z() <= fUpper.z())
+  {
+    return false;
+  }
+
+  axis = (0.5 * (fLower + fUpper) - position).unit();
+  cosCone = 1.;
+  for(const auto& corner : fCorners)
+  {
+    cosCone = std::min(cosCone, axis.dot((corner - position).unit()));
+  }
+  // a cone of 90 deg or more gains nothing over 4 pi
+  return cosCone > 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double DirectionBias::Sample(const G4ThreeVector& position,
+                               G4ThreeVector& direction) const
+{
+  G4ThreeVector axis;
+  G4double cosCone = -1.;
+  const G4bool biased = IsEnabled() && GetCone(position, axis, cosCone);
+
+  G4double cosTheta = 1.0 - 2.0 * G4UniformRand();
+  G4double phi = twopi * G4UniformRand();
+  const G4bool inConeDraw = biased && G4UniformRand() < fFraction;
+  if(inConeDraw)
+  {
+    cosTheta = 1.0 - G4UniformRand() * (1.0 - cosCone);
+  }
+  G4double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
+  direction.set(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+  if(inConeDraw)
+  {
+    direction.rotateUz(axis);
+  }
+  if(!biased) return 1.;
+
+  // isotropic density over the mixture density
+  const G4bool inCone = direction.dot(axis) >= cosCone;
+  return 1. / ((1. - fFraction) + (inCone ? 2. * fFraction / (1. - cosCone) : 0.));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,358 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/src/FarmDriver.cc
+/// \brief Implementation of the FarmDriver class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "FarmDriver.hh"
+#include "HistoManager.hh"
+#include "Run.hh"
+
+#include "G4AnalysisManager.hh"
+#include "G4AutoLock.hh"
+#include "G4RootAnalysisReader.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+G4Mutex outputMutex = G4MUTEX_INITIALIZER;
+G4int nFinished = 0;
+
+// a line of a shard: a run or scan point of a process
+// (RunParameters::farmShard)
+struct ShardLine
+{
+  G4int events = 0;
+  Tally created;  // scintillation photons
+  Tally detected;
+  std::array<G4double, TankSD::kNSpecies> tank{};
+};
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FarmDriver::FarmDriver(const G4String& program, G4int nProcesses)
+  : fProgram(program), fNProcesses(nProcesses)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FarmDriver::SetOutputFileName(const G4String& name)
+{
+  // as Run::SetOutputFileName()
+  const auto pos = name.find(".txt");
+  fStem = name.substr(0, pos);
+  fOutputFileName = pos == std::string::npos ? name + ".txt" : name;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FarmDriver::SetEvents(G4int eventsPerRun, G4int nRuns)
+{
+  fEventsPerRun = eventsPerRun;
+  fNRuns = nRuns;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool FarmDriver::Run()
+{
+  std::vector<Shard> shards;
+  for(G4int i = 0; i < fNProcesses; ++i)
+  {
+    Shard shard;
+    shard.index = i;
+    shard.events = fEventsPerRun / fNProcesses + (i < fEventsPerRun % fNProcesses ? 1 : 0);
+    shard.name = fStem + "_shard" + std::to_string(i);
+    if(shard.events == 0)
+      break;  // more processes than events
+    // the process appends to its shard, as to the output file
+    std::remove((shard.name + ".txt").c_str());
+    for(G4int run = 0; run < fNRuns; ++run)
+      std::remove(GetHistogramFile(shard.name, run).c_str());
+    shards.push_back(shard);
+  }
+
+  G4cout << "Farm: " << shards.size() << " processes, " << fNRuns << " runs of "
+         << fEventsPerRun << " events, seed " << fSeed << G4endl;
+  for(const auto& shard : shards)
+  {
+    G4cout << "  " << shard.name << ": " << shard.events << " events per run, stream "
+           << shard.index + 1 << ", log " << shard.name << ".log" << G4endl;
+  }
+
+  nFinished = 0;
+  std::vector<std::thread> threads;
+  for(auto& shard : shards)
+    threads.emplace_back(&FarmDriver::Execute, this, std::ref(shard));
+  for(auto& thread : threads)
+    thread.join();
+
+  std::vector<const Shard*> done;
+  for(const auto& shard : shards)
+  {
+    if(shard.status == 0)
+      done.push_back(&shard);
+  }
+  if(done.size() < shards.size())
+  {
+    G4ExceptionDescription ed;
+    ed << shards.size() - done.size() << " of " << shards.size()
+       << " processes failed (see their logs);" << G4endl
+       << "the results are merged without them.";
+    G4Exception("FarmDriver::Run", "OpNovice2_010", JustWarning, ed);
+  }
+  if(!done.empty())
+  {
+    MergeCounters(done);
+    MergeHistograms(done);
+  }
+  return done.size() == shards.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String FarmDriver::GetCommand(const Shard& shard) const
+{
+  std::ostringstream command;
+  command << '"' << fProgram << '"';
+  for(const auto& arg : fArguments)
+    command << ' ' << arg;
+  command << " -o \"" << shard.name << "\" -n " << shard.events << " -r " << fNRuns
+          << " --seed " << fSeed << " --shard " << shard.index << " --histograms \""
+          << shard.name << "\""
+          << " > \"" << shard.name << ".log\" 2>&1";
+#ifdef _WIN32
+  // cmd /c drops the first and the last quote of the command
+  return "\"" + command.str() + "\"";
+#else
+  return command.str();
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FarmDriver::Execute(Shard& shard) const
+{
+  const auto start = std::chrono::steady_clock::now();
+  shard.status = std::system(GetCommand(shard).c_str());
+  shard.seconds = std::chrono::duration<G4double>(
+                    std::chrono::steady_clock::now() - start).count();
+
+  G4AutoLock lock(&outputMutex);
+  ++nFinished;
+  G4cout << "Farm: " << shard.name;
+  if(shard.status == 0)
+    G4cout << " done";
+  else
+    G4cout << " FAILED (exit status " << shard.status << ")";
+  G4cout << " after " << std::fixed << std::setprecision(1) << shard.seconds
+         << " s, " << nFinished << "/" << fNProcesses << " finished" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FarmDriver::MergeCounters(const std::vector<const Shard*>& shards) const
+{
+  // line k of each shard is the run (or scan point) k
+  std::vector<std::vector<ShardLine>> lines;
+  std::size_t nLines = std::numeric_limits<std::size_t>::max();
+  for(const Shard* shard : shards)
+  {
+    std::ifstream in(shard->name + ".txt");
+    lines.emplace_back();
+    ShardLine line;
+    while(in >> line.events >> line.created.sum >> line.created.sum2 >> line.detected.sum
+          >> line.detected.sum2 >> line.tank[TankSD::kAlpha] >> line.tank[TankSD::kBeta]
+          >> line.tank[TankSD::kGamma])
+    {
+      lines.back().push_back(line);
+    }
+    nLines = std::min(nLines, lines.back().size());
+  }
+  for(std::size_t s = 0; s < shards.size(); ++s)
+  {
+    if(lines[s].size() != nLines)
+    {
+      G4ExceptionDescription ed;
+      ed << shards[s]->name << ".txt has " << lines[s].size() << " lines instead of "
+         << nLines << ";" << G4endl << "only the first " << nLines << " are merged.";
+      G4Exception("FarmDriver::MergeCounters", "OpNovice2_010", JustWarning, ed);
+    }
+  }
+
+  std::ofstream outputFile(fOutputFileName, std::ios::app);
+  if(!outputFile)
+  {
+    G4cerr << "Error opening file: " << fOutputFileName << G4endl;
+    return;
+  }
+  G4cout << "Farm: " << nLines << " lines merged into " << fOutputFileName
+         << " (created photons per event, detected photons, yield):" << G4endl;
+  for(std::size_t k = 0; k < nLines; ++k)
+  {
+    // the sums over the events of all the processes, as in the Run of a
+    // single process
+    ShardLine merged;
+    for(const auto& shardLines : lines)
+    {
+      const ShardLine& line = shardLines[k];
+      merged.events += line.events;
+      merged.created.Merge(line.created);
+      merged.detected.Merge(line.detected);
+      for(std::size_t i = 0; i < merged.tank.size(); ++i)
+        merged.tank[i] += line.tank[i];
+    }
+    if(merged.events == 0)
+      continue;
+    const G4double created = merged.created.sum / merged.events;
+    const G4double yield = created > 0. ? merged.detected.sum / created * 100 : 0.;
+
+    // the line of Run::EndOfRun()
+    outputFile << std::fixed << std::setprecision(2) << created << " "
+               << merged.detected.sum << " " << yield << " " << merged.tank[TankSD::kAlpha]
+               << " " << merged.tank[TankSD::kBeta] << " " << merged.tank[TankSD::kGamma]
+               << std::endl;
+    G4cout << "  " << k << ": " << merged.events << " events, " << std::fixed
+           << std::setprecision(2) << created << " +- "
+           << merged.created.GetError(merged.events) / merged.events << ", "
+           << merged.detected.sum << " +- " << merged.detected.GetError(merged.events)
+           << ", " << yield << " %" << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FarmDriver::MergeHistograms(const std::vector<const Shard*>& shards) const
+{
+  // the files of run k are merged into <histograms>_run<k>.root, and all
+  // of them into the file of the job
+  HistoManager histoManager;
+  G4AnalysisManager* analysisMan = G4AnalysisManager::Instance();
+  const G4String jobFile = analysisMan->GetFileName();
+  auto reader = G4RootAnalysisReader::Instance();
+  std::vector<std::unique_ptr<tools::histo::h1d>> totals(analysisMan->GetNofH1s());
+
+  for(G4int run = 0; run < fNRuns; ++run)
+  {
+    std::vector<G4String> files;
+    for(const Shard* shard : shards)
+    {
+      const G4String file = GetHistogramFile(shard->name, run);
+      if(std::ifstream(file))
+        files.push_back(file);
+    }
+    if(files.empty())
+      continue;
+
+    for(G4int id = 0; id < analysisMan->GetNofH1s(); ++id)
+    {
+      const G4String name = analysisMan->GetH1Name(id);
+      tools::histo::h1d* sum = nullptr;
+      for(const auto& file : files)
+      {
+        const G4int readId = reader->ReadH1(name, file);
+        if(readId < 0)
+          continue;  // not written by this process
+        const tools::histo::h1d* h1 = reader->GetH1(readId);
+        if(!sum)
+        {
+          analysisMan->SetH1(id, h1->axis().bins(), h1->axis().lower_edge(),
+                             h1->axis().upper_edge());
+          sum = analysisMan->GetH1(id);
+        }
+        if(!sum->add(*h1))
+        {
+          G4ExceptionDescription ed;
+          ed << "Histogram " << name << " of " << file
+             << " has another binning; it is left out.";
+          G4Exception("FarmDriver::MergeHistograms", "OpNovice2_010", JustWarning, ed);
+        }
+      }
+      if(!sum)
+        continue;
+      analysisMan->SetH1Activation(id, true);
+      if(!totals[id])
+        totals[id] = std::make_unique<tools::histo::h1d>(*sum);
+      else if(!totals[id]->add(*sum))
+      {
+        G4ExceptionDescription ed;
+        ed << "Histogram " << name << " of run " << run
+           << " has another binning than in the first run;" << G4endl
+           << "it is left out of " << jobFile << ".";
+        G4Exception("FarmDriver::MergeHistograms", "OpNovice2_010", JustWarning, ed);
+      }
+    }
+    // closing resets the histograms for the next run
+    analysisMan->OpenFile(jobFile + "_run" + std::to_string(run));
+    analysisMan->Write();
+    analysisMan->CloseFile();
+  }
+
+  G4int nMerged = 0;
+  for(G4int id = 0; id < analysisMan->GetNofH1s(); ++id)
+  {
+    if(!totals[id])
+      continue;
+    *analysisMan->GetH1(id) = *totals[id];
+    ++nMerged;
+  }
+  if(nMerged == 0)
+  {
+    G4cout << "Farm: the processes wrote no histograms" << G4endl;
+    return;
+  }
+  analysisMan->OpenFile(jobFile);
+  analysisMan->Write();
+  analysisMan->CloseFile();
+  G4cout << "Farm: " << nMerged << " histograms merged into " << jobFile
+         << "_run<k>.root for each run and into " << jobFile << ".root for the job"
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String FarmDriver::GetHistogramFile(const G4String& name, G4int run)
+{
+  // as OpNovice2 --histograms
+  return name + "_run" + std::to_string(run) + ".root";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,533 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/src/LightMap.cc
+/// \brief Implementation of the LightMap class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "LightMap.hh"
+
+#include "DetectorConstruction.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalSurface.hh"
+#include "G4SurfaceProperty.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+// 64-bit FNV-1a
+class Hasher
+{
+ public:
+  void Add(const void* data, std::size_t size)
+  {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for(std::size_t i = 0; i < size; ++i)
+    {
+      fValue = (fValue ^ bytes[i]) * 0x100000001b3ULL;
+    }
+  }
+  void Add(G4double val) { Add(&val, sizeof(val)); }
+  void Add(G4int val) { Add(&val, sizeof(val)); }
+  void Add(const G4String& val) { Add(val.data(), val.size()); }
+  void Add(const G4ThreeVector& val)
+  {
+    Add(val.x());
+    Add(val.y());
+    Add(val.z());
+  }
+  void Add(const G4MaterialPropertiesTable* mpt);
+
+  std::uint64_t Value() const { return fValue; }
+
+ private:
+  std::uint64_t fValue = 0xcbf29ce484222325ULL;
+};
+
+void Hasher::Add(const G4MaterialPropertiesTable* mpt)
+{
+  if(!mpt)
+  {
+    Add(-1);
+    return;
+  }
+  const auto& properties = mpt->GetProperties();
+  for(std::size_t i = 0; i < properties.size(); ++i)
+  {
+    const G4MaterialPropertyVector* vec = properties[i];
+    if(!vec) continue;
+    Add(static_cast<G4int>(i));
+    for(std::size_t j = 0; j < vec->GetVectorLength(); ++j)
+    {
+      Add(vec->Energy(j));
+      Add((*vec)[j]);
+    }
+  }
+  const auto& constProperties = mpt->GetConstProperties();
+  for(std::size_t i = 0; i < constProperties.size(); ++i)
+  {
+    if(!constProperties[i].second) continue;
+    Add(static_cast<G4int>(i));
+    Add(constProperties[i].first);
+  }
+}
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LightMap::SetGrid(G4int nx, G4int ny, G4int nz)
+{
+  fGrid = { { std::max(nx, 1), std::max(ny, 1), std::max(nz, 1) } };
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LightMap::Build(const DetectorConstruction* detector,
+                     const G4VPhysicalVolume* world)
+{
+  fVolumes.clear();
+  fCells.clear();
+  if(!detector || !world) return;
+
+  AddVolumes(detector, world, G4Transform3D());
+
+  G4int nCells = 0;
+  for(auto& volume : fVolumes)
+  {
+    volume.firstCell = nCells;
+    nCells += fGrid[0] * fGrid[1] * fGrid[2];
+  }
+  fCells.assign(nCells, Cell());
+
+  // everything the collection efficiency depends on: the grid, every
+  // placed volume, and the optical properties of materials and surfaces
+  Hasher hash;
+  for(G4int n : fGrid) hash.Add(n);
+
+  std::vector<const G4VPhysicalVolume*> stack = { world };
+  while(!stack.empty())
+  {
+    const G4VPhysicalVolume* pv = stack.back();
+    stack.pop_back();
+    const G4LogicalVolume* lv = pv->GetLogicalVolume();
+    std::ostringstream solid;
+    lv->GetSolid()->StreamInfo(solid);
+    hash.Add(pv->GetName());
+    hash.Add(pv->GetCopyNo());
+    hash.Add(pv->GetObjectTranslation());
+    const G4RotationMatrix rotation = pv->GetObjectRotationValue();
+    hash.Add(rotation.colX());
+    hash.Add(rotation.colY());
+    hash.Add(rotation.colZ());
+    hash.Add(G4String(solid.str()));
+    hash.Add(lv->GetMaterial()->GetName());
+    for(std::size_t i = lv->GetNoDaughters(); i > 0; --i)
+    {
+      stack.push_back(lv->GetDaughter(i - 1));
+    }
+  }
+
+  for(const G4Material* material : *G4Material::GetMaterialTable())
+  {
+    hash.Add(material->GetName());
+    hash.Add(material->GetMaterialPropertiesTable());
+  }
+
+  const G4SurfacePropertyTable* surfaces =
+    G4SurfaceProperty::GetSurfacePropertyTable();
+  for(const G4SurfaceProperty* surface : *surfaces)
+  {
+    hash.Add(surface->GetName());
+    hash.Add(static_cast<G4int>(surface->GetType()));
+    auto optical = dynamic_cast<const G4OpticalSurface*>(surface);
+    if(!optical) continue;
+    hash.Add(static_cast<G4int>(optical->GetModel()));
+    hash.Add(static_cast<G4int>(optical->GetFinish()));
+    hash.Add(optical->GetSigmaAlpha());
+    hash.Add(optical->GetPolish());
+    hash.Add(optical->GetMaterialPropertiesTable());
+  }
+
+  fHash = hash.Value();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LightMap::AddVolumes(const DetectorConstruction* detector,
+                          const G4VPhysicalVolume* pv,
+                          const G4Transform3D& toMother)
+{
+  const G4LogicalVolume* lv = pv->GetLogicalVolume();
+  const G4Transform3D toGlobal =
+    toMother * G4Transform3D(pv->GetObjectRotationValue(),
+                             pv->GetObjectTranslation());
+
+  if(detector->GetVolumeRole(lv) == VolumeRole::Scintillator)
+  {
+    const G4MaterialPropertiesTable* mpt =
+      lv->GetMaterial()->GetMaterialPropertiesTable();
+    const G4MaterialPropertyVector* spectrum =
+      mpt ? mpt->GetProperty(kSCINTILLATIONCOMPONENT1) : nullptr;
+    if(!spectrum || spectrum->GetVectorLength() < 2)
+    {
+      G4ExceptionDescription ed;
+      ed << "Scintillator " << pv->GetName() << " (material "
+         << lv->GetMaterial()->GetName()
+         << ") has no SCINTILLATIONCOMPONENT1 spectrum;" << G4endl
+         << "it is left out of the light map.";
+      G4Exception("LightMap::Build", "OpNovice2_005", JustWarning, ed);
+    }
+    else
+    {
+      Volume volume;
+      volume.name = pv->GetName();
+      volume.solid = lv->GetSolid();
+      volume.toGlobal = toGlobal;
+      volume.toLocal = toGlobal.inverse();
+      volume.solid->BoundingLimits(volume.lower, volume.upper);
+
+      // integrated spectrum, trapezoidal as in G4Scintillation
+      const std::size_t n = spectrum->GetVectorLength();
+      volume.energies.resize(n);
+      volume.integral.resize(n);
+      volume.energies[0] = spectrum->Energy(0);
+      volume.integral[0] = 0.;
+      for(std::size_t i = 1; i < n; ++i)
+      {
+        volume.energies[i] = spectrum->Energy(i);
+        volume.integral[i] =
+          volume.integral[i - 1] + 0.5 * ((*spectrum)[i] + (*spectrum)[i - 1]) *
+                                     (volume.energies[i] - volume.energies[i - 1]);
+      }
+      fVolumes.push_back(volume);
+    }
+  }
+
+  for(std::size_t i = 0; i < lv->GetNoDaughters(); ++i)
+  {
+    const G4VPhysicalVolume* daughter = lv->GetDaughter(i);
+    // replicas and parameterisations have no single placement
+    if(daughter->IsReplicated() || daughter->IsParameterised()) continue;
+    AddVolumes(detector, daughter, toGlobal);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LightMap::Reset()
+{
+  std::fill(fCells.begin(), fCells.end(), Cell());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String LightMap::GetFileName() const
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "lce_%016llx.bin",
+                static_cast<unsigned long long>(fHash));
+  return name;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const LightMap::Volume* LightMap::FindVolume(G4int cell) const
+{
+  const G4int cellsPerVolume = fGrid[0] * fGrid[1] * fGrid[2];
+  const G4int index = cell / cellsPerVolume;
+  if(cell < 0 || index >= static_cast<G4int>(fVolumes.size())) return nullptr;
+  return &fVolumes[index];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool LightMap::SampleEmission(G4int cell, G4ThreeVector& position,
+                                G4double& energy) const
+{
+  const Volume* volume = FindVolume(cell);
+  if(!volume) return false;
+
+  G4int local = cell - volume->firstCell;
+  const G4int ix = local % fGrid[0];
+  local /= fGrid[0];
+  const G4int iy = local % fGrid[1];
+  const G4int iz = local / fGrid[1];
+
+  const G4ThreeVector size = volume->upper - volume->lower;
+  const G4ThreeVector cellSize(size.x() / fGrid[0], size.y() / fGrid[1],
+                               size.z() / fGrid[2]);
+  const G4ThreeVector corner =
+    volume->lower + G4ThreeVector(ix * cellSize.x(), iy * cellSize.y(),
+                                  iz * cellSize.z());
+
+  // cells on the edge of a non-box solid are only partly inside it
+  const G4int maxTries = 100;
+  G4bool found = false;
+  G4ThreeVector point;
+  for(G4int i = 0; i < maxTries && !found; ++i)
+  {
+    point = corner + G4ThreeVector(G4UniformRand() * cellSize.x(),
+                                   G4UniformRand() * cellSize.y(),
+                                   G4UniformRand() * cellSize.z());
+    found = volume->solid->Inside(point) == kInside;
+  }
+  if(!found) return false;
+  position = volume->toGlobal * HepGeom::Point3D<G4double>(point);
+
+  // invert the integrated spectrum, linearly within a bin
+  const G4double target = G4UniformRand() * volume->integral.back();
+  auto upper = std::upper_bound(volume->integral.begin(),
+                                volume->integral.end(), target);
+  std::size_t bin = std::min<std::size_t>(
+    std::max<std::ptrdiff_t>(upper - volume->integral.begin(), 1),
+    volume->integral.size() - 1);
+  const G4double i0 = volume->integral[bin - 1];
+  const G4double i1 = volume->integral[bin];
+  const G4double e0 = volume->energies[bin - 1];
+  const G4double e1 = volume->energies[bin];
+  energy = i1 > i0 ? e0 + (target - i0) / (i1 - i0) * (e1 - e0) : e0;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int LightMap::FindCell(const G4ThreeVector& position) const
+{
+  for(const auto& volume : fVolumes)
+  {
+    const G4ThreeVector point =
+      volume.toLocal * HepGeom::Point3D<G4double>(position);
+    if(point.x() < volume.lower.x() || point.x() >= volume.upper.x() ||
+       point.y() < volume.lower.y() || point.y() >= volume.upper.y() ||
+       point.z() < volume.lower.z() || point.z() >= volume.upper.z())
+    {
+      continue;
+    }
+    // bounding boxes of neighbouring solids may overlap
+    if(volume.solid->Inside(point) == kOutside) continue;
+
+    const G4ThreeVector size = volume.upper - volume.lower;
+    const G4ThreeVector offset = point - volume.lower;
+    const G4int ix = std::min(
+      static_cast<G4int>(offset.x() / size.x() * fGrid[0]), fGrid[0] - 1);
+    const G4int iy = std::min(
+      static_cast<G4int>(offset.y() / size.y() * fGrid[1]), fGrid[1] - 1);
+    const G4int iz = std::min(
+      static_cast<G4int>(offset.z() / size.z() * fGrid[2]), fGrid[2] - 1);
+    const G4int cell = volume.firstCell + ix + fGrid[0] * (iy + fGrid[1] * iz);
+    return fCells[cell].emitted > 0. ? cell : -1;
+  }
+  return -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double LightMap::SampleArrivalTime(G4int cell) const
+{
+  // Gaussian with the moments of the cell; the shape of the arrival time
+  // distribution is not stored
+  const Cell& tally = fCells[cell];
+  if(tally.detected <= 0.) return 0.;
+  const G4double mean = tally.sumTime / tally.detected;
+  const G4double rms =
+    std::sqrt(std::max(tally.sumTime2 / tally.detected - mean * mean, 0.));
+  return std::max(G4RandGauss::shoot(mean, rms), 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LightMap::AddEvent(G4int cell, G4double emitted, G4double detected,
+                        G4double sumTime, G4double sumTime2)
+{
+  if(cell < 0 || cell >= GetNCells()) return;
+  Cell& tally = fCells[cell];
+  tally.emitted += emitted;
+  tally.detected += detected;
+  tally.sumTime += sumTime;
+  tally.sumTime2 += sumTime2;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LightMap::Merge(const LightMap& other)
+{
+  if(other.fCells.empty()) return;
+  if(fCells.empty())
+  {
+    // the master run has no geometry of its own; take the worker's grid
+    *this = other;
+    return;
+  }
+  if(other.fHash != fHash || other.fCells.size() != fCells.size()) return;
+
+  for(std::size_t i = 0; i < fCells.size(); ++i)
+  {
+    fCells[i].emitted += other.fCells[i].emitted;
+    fCells[i].detected += other.fCells[i].detected;
+    fCells[i].sumTime += other.fCells[i].sumTime;
+    fCells[i].sumTime2 += other.fCells[i].sumTime2;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool LightMap::Write(const G4String& fileName) const
+{
+  // header: magic, version, hash, grid, volumes (name and local bounding
+  // box); then the cell tallies in volume, z, y, x order
+  std::ofstream out(fileName, std::ios::binary);
+  if(!out) return false;
+
+  const char magic[8] = { 'O', 'P', 'N', '2', 'L', 'C', 'E', '\0' };
+  const std::uint32_t version = 1;
+  const auto nVolumes = static_cast<std::uint32_t>(fVolumes.size());
+  const auto nCells = static_cast<std::uint32_t>(fCells.size());
+
+  out.write(magic, sizeof(magic));
+  out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  out.write(reinterpret_cast<const char*>(&fHash), sizeof(fHash));
+  out.write(reinterpret_cast<const char*>(fGrid.data()), sizeof(fGrid));
+  out.write(reinterpret_cast<const char*>(&nVolumes), sizeof(nVolumes));
+  for(const auto& volume : fVolumes)
+  {
+    const auto length = static_cast<std::uint32_t>(volume.name.size());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(volume.name.data(), length);
+    const G4double box[6] = { volume.lower.x(), volume.lower.y(),
+                              volume.lower.z(), volume.upper.x(),
+                              volume.upper.y(), volume.upper.z() };
+    out.write(reinterpret_cast<const char*>(box), sizeof(box));
+  }
+  out.write(reinterpret_cast<const char*>(&nCells), sizeof(nCells));
+  out.write(reinterpret_cast<const char*>(fCells.data()),
+            fCells.size() * sizeof(Cell));
+  return static_cast<G4bool>(out);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool LightMap::Read(const G4String& fileName)
+{
+  // same layout as Write(); the geometry in the header has to match the
+  // grid built for the current run
+  std::ifstream in(fileName, std::ios::binary);
+  if(!in) return false;
+
+  char magic[8];
+  std::uint32_t version = 0;
+  std::uint64_t hash = 0;
+  std::array<G4int, 3> grid{};
+  std::uint32_t nVolumes = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  in.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+  in.read(reinterpret_cast<char*>(grid.data()), sizeof(grid));
+  in.read(reinterpret_cast<char*>(&nVolumes), sizeof(nVolumes));
+  if(!in || std::strncmp(magic, "OPN2LCE", sizeof(magic)) != 0 ||
+     version != 1 || hash != fHash || grid != fGrid ||
+     nVolumes != fVolumes.size())
+  {
+    return false;
+  }
+
+  for(const auto& volume : fVolumes)
+  {
+    std::uint32_t length = 0;
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    std::string name(length, '\0');
+    in.read(&name[0], length);
+    G4double box[6];
+    in.read(reinterpret_cast<char*>(box), sizeof(box));
+    if(!in || name != volume.name) return false;
+  }
+
+  std::uint32_t nCells = 0;
+  in.read(reinterpret_cast<char*>(&nCells), sizeof(nCells));
+  if(!in || nCells != fCells.size()) return false;
+  std::vector<Cell> cells(nCells);
+  in.read(reinterpret_cast<char*>(cells.data()), nCells * sizeof(Cell));
+  if(!in) return false;
+
+  fCells = std::move(cells);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LightMap::Print() const
+{
+  G4cout << " Light map: " << fVolumes.size() << " volume(s), " << fGrid[0]
+         << " x " << fGrid[1] << " x " << fGrid[2] << " cells each" << G4endl;
+
+  for(const auto& volume : fVolumes)
+  {
+    G4double emitted = 0.;
+    G4double detected = 0.;
+    G4double sumTime = 0.;
+    G4double sumTime2 = 0.;
+    G4int cellsFilled = 0;
+    const G4int nCells = fGrid[0] * fGrid[1] * fGrid[2];
+    for(G4int i = volume.firstCell; i < volume.firstCell + nCells; ++i)
+    {
+      emitted += fCells[i].emitted;
+      detected += fCells[i].detected;
+      sumTime += fCells[i].sumTime;
+      sumTime2 += fCells[i].sumTime2;
+      if(fCells[i].emitted > 0.) ++cellsFilled;
+    }
+
+    G4cout << "  " << volume.name << ": " << cellsFilled << "/" << nCells
+           << " cells filled";
+    if(emitted > 0.)
+    {
+      G4cout << ", LCE = " << detected / emitted;
+    }
+    if(detected > 0.)
+    {
+      const G4double mean = sumTime / detected;
+      const G4double rms =
+        std::sqrt(std::max(sumTime2 / detected - mean * mean, 0.));
+      G4cout << ", arrival time: mean = " << mean / ns
+             << " ns; rms = " << rms / ns << " ns";
+    }
+    G4cout << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
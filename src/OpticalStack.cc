@@ -0,0 +1,574 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/src/OpticalStack.cc
+/// \brief Implementation of the OpticalStack class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "OpticalStack.hh"
+
+#include "DetectorConstruction.hh"
+
+#include "G4LogicalBorderSurface.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalSurface.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "Randomize.hh"
+#include "geomdefs.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// faces closer than this are taken as touching
+constexpr G4double kTouching = 1. * um;
+
+G4double Evaluate(const G4MaterialPropertyVector* vector, G4double energy,
+                  G4double fallback)
+{
+  return vector ? vector->Value(energy) : fallback;
+}
+
+const G4MaterialPropertyVector* GetVector(const G4MaterialPropertiesTable* mpt,
+                                          const G4String& name)
+{
+  return mpt ? mpt->GetProperty(name) : nullptr;
+}
+
+const G4OpticalSurface* GetBorderSurface(const G4VPhysicalVolume* from,
+                                         const G4VPhysicalVolume* to)
+{
+  const G4LogicalBorderSurface* border = G4LogicalBorderSurface::GetSurface(from, to);
+  return border ? dynamic_cast<const G4OpticalSurface*>(border->GetSurfaceProperty())
+                : nullptr;
+}
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RayTraceTally::Merge(const RayTraceTally& other)
+{
+  photons += other.photons;
+  detected += other.detected;
+  absorbed += other.absorbed;
+  absorbedPrior += other.absorbedPrior;
+  rayleigh += other.rayleigh;
+  surface += other.surface;
+  escaped += other.escaped;
+  lost += other.lost;
+  for(std::size_t i = 0; i < firstStatus.size(); ++i)
+  {
+    firstStatus[i] += other.firstStatus[i];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool OpticalStack::Build(const DetectorConstruction* detector,
+                           const G4VPhysicalVolume* world)
+{
+  fLayers.clear();
+  fReflectors.clear();
+  fReflectorReflectivity.clear();
+  if(!detector || !world) return false;
+
+  struct Placement
+  {
+    const G4VPhysicalVolume* pv;
+    G4ThreeVector lower;
+    G4ThreeVector upper;
+  };
+  std::vector<Placement> layers;
+  std::vector<Placement> reflectors;
+
+  const G4LogicalVolume* worldLV = world->GetLogicalVolume();
+  for(std::size_t i = 0; i < worldLV->GetNoDaughters(); ++i)
+  {
+    const G4VPhysicalVolume* pv = worldLV->GetDaughter(i);
+    const G4RotationMatrix* rotation = pv->GetRotation();
+    if(rotation && !rotation->isIdentity()) continue;
+
+    const G4VSolid* solid = pv->GetLogicalVolume()->GetSolid();
+    const G4ThreeVector translation = pv->GetTranslation();
+    G4ThreeVector lower, upper;
+    solid->BoundingLimits(lower, upper);
+    Placement placement{ pv, lower + translation, upper + translation };
+
+    // a layer if the solid itself (not only its box) is on the axis
+    const G4double zMid = 0.5 * (placement.lower.z() + placement.upper.z());
+    const G4ThreeVector axisPoint(-translation.x(), -translation.y(),
+                                  zMid - translation.z());
+    if(solid->Inside(axisPoint) != kOutside)
+    {
+      layers.push_back(placement);
+    }
+    else if(detector->GetVolumeRole(pv) == VolumeRole::Reflector)
+    {
+      reflectors.push_back(placement);
+    }
+  }
+
+  // overlapping layers (e.g. a grease grid inside the GSO layer): keep the
+  // one with the larger cross section
+  std::sort(layers.begin(), layers.end(), [](const Placement& a, const Placement& b) {
+    return a.lower.z() < b.lower.z();
+  });
+  auto area = [](const Placement& p) {
+    return (p.upper.x() - p.lower.x()) * (p.upper.y() - p.lower.y());
+  };
+  std::vector<Placement> stack;
+  for(const auto& placement : layers)
+  {
+    if(!stack.empty() && placement.lower.z() < stack.back().upper.z() - kTouching)
+    {
+      if(area(placement) > area(stack.back())) stack.back() = placement;
+      continue;
+    }
+    stack.push_back(placement);
+  }
+
+  // common energy grid over the RINDEX of the layers
+  fEnergyMin = std::numeric_limits<G4double>::max();
+  fEnergyMax = 0.;
+  for(const auto& placement : stack)
+  {
+    const G4MaterialPropertiesTable* mpt =
+      placement.pv->GetLogicalVolume()->GetMaterial()->GetMaterialPropertiesTable();
+    const G4MaterialPropertyVector* rindex = GetVector(mpt, "RINDEX");
+    if(!rindex) continue;
+    fEnergyMin = std::min(fEnergyMin, rindex->GetMinEnergy());
+    fEnergyMax = std::max(fEnergyMax, rindex->GetMaxEnergy());
+  }
+  if(fEnergyMax <= 0.) return false;
+  if(fEnergyMax <= fEnergyMin) fEnergyMax = fEnergyMin * (1. + 1.e-6);
+
+  auto energyOf = [this](G4int bin) {
+    return fEnergyMin + (fEnergyMax - fEnergyMin) * bin / (fNBins - 1);
+  };
+
+  const G4MaterialPropertiesTable* worldMPT =
+    worldLV->GetMaterial()->GetMaterialPropertiesTable();
+  const G4MaterialPropertyVector* worldRindex = GetVector(worldMPT, "RINDEX");
+  fWorldRindex.assign(fNBins, 0.);
+  for(G4int bin = 0; bin < fNBins; ++bin)
+  {
+    fWorldRindex[bin] = Evaluate(worldRindex, energyOf(bin), 0.);
+  }
+
+  for(const auto& placement : reflectors)
+  {
+    Reflector reflector;
+    reflector.zLow = placement.lower.z();
+    reflector.zHigh = placement.upper.z();
+    fReflectors.push_back(reflector);
+
+    const G4OpticalSurface* surface = GetBorderSurface(placement.pv, world);
+    const G4MaterialPropertyVector* reflectivity =
+      GetVector(surface ? surface->GetMaterialPropertiesTable() : nullptr, "REFLECTIVITY");
+    for(G4int bin = 0; bin < fNBins; ++bin)
+    {
+      fReflectorReflectivity.push_back(Evaluate(reflectivity, energyOf(bin), 0.));
+    }
+  }
+
+  fProperties.assign(stack.size() * fNBins * kNProperties, 0.);
+  fSurfaceReflectivity.assign(stack.size() * fNBins, 0.);
+  for(std::size_t l = 0; l < stack.size(); ++l)
+  {
+    const Placement& placement = stack[l];
+    Layer layer;
+    layer.name = placement.pv->GetName();
+    for(G4int k = 0; k < 3; ++k)
+    {
+      layer.lower[k] = placement.lower[k];
+      layer.upper[k] = placement.upper[k];
+    }
+    layer.detector = detector->GetVolumeRole(placement.pv) == VolumeRole::Tank;
+
+    const G4MaterialPropertiesTable* mpt =
+      placement.pv->GetLogicalVolume()->GetMaterial()->GetMaterialPropertiesTable();
+    const G4MaterialPropertyVector* rindex = GetVector(mpt, "RINDEX");
+    const G4MaterialPropertyVector* absLength = GetVector(mpt, "ABSLENGTH");
+    const G4MaterialPropertyVector* rayleigh = GetVector(mpt, "RAYLEIGH");
+    layer.opaque = rindex == nullptr;
+
+    const G4OpticalSurface* surface = GetBorderSurface(placement.pv, world);
+    layer.metal = surface && surface->GetType() == dielectric_metal;
+    const G4MaterialPropertyVector* reflectivity =
+      GetVector(surface ? surface->GetMaterialPropertiesTable() : nullptr, "REFLECTIVITY");
+
+    for(G4int bin = 0; bin < fNBins; ++bin)
+    {
+      const G4double energy = energyOf(bin);
+      const std::size_t index = (l * fNBins + bin) * kNProperties;
+      fProperties[index + kRindex] = Evaluate(rindex, energy, 0.);
+      fProperties[index + kAbsLength] = Evaluate(absLength, energy, kInfinity);
+      fProperties[index + kRayleigh] = Evaluate(rayleigh, energy, kInfinity);
+      fSurfaceReflectivity[l * fNBins + bin] = Evaluate(reflectivity, energy, 1.);
+    }
+
+    // the reflector around most of the layer's height
+    G4double bestOverlap = 0.;
+    for(std::size_t r = 0; r < fReflectors.size(); ++r)
+    {
+      const G4double overlap = std::min(layer.upper[2], fReflectors[r].zHigh)
+                               - std::max(layer.lower[2], fReflectors[r].zLow);
+      if(overlap > bestOverlap)
+      {
+        bestOverlap = overlap;
+        layer.reflector = static_cast<G4int>(r);
+      }
+    }
+    fLayers.push_back(layer);
+  }
+
+  for(std::size_t l = 0; l + 1 < fLayers.size(); ++l)
+  {
+    if(fLayers[l + 1].lower[2] - fLayers[l].upper[2] < kTouching)
+    {
+      fLayers[l].above = static_cast<G4int>(l + 1);
+      fLayers[l + 1].below = static_cast<G4int>(l);
+    }
+  }
+  return !fLayers.empty();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int OpticalStack::FindLayer(const G4ThreeVector& position) const
+{
+  for(std::size_t l = 0; l < fLayers.size(); ++l)
+  {
+    const Layer& layer = fLayers[l];
+    G4bool inside = true;
+    for(G4int k = 0; k < 3; ++k)
+    {
+      inside = inside && position[k] >= layer.lower[k] && position[k] <= layer.upper[k];
+    }
+    if(inside) return static_cast<G4int>(l);
+  }
+  return -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int OpticalStack::GetBin(G4double energy) const
+{
+  const G4double x = (energy - fEnergyMin) / (fEnergyMax - fEnergyMin) * (fNBins - 1);
+  return std::min(std::max(static_cast<G4int>(x + 0.5), 0), fNBins - 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool OpticalStack::Add(PhotonBatch& batch, const G4ThreeVector& position,
+                         const G4ThreeVector& direction, G4double energy) const
+{
+  const G4int layer = FindLayer(position);
+  if(layer < 0 || fLayers[layer].opaque || batch.IsFull()) return false;
+
+  const std::size_t i = batch.size++;
+  batch.x[i] = position.x();
+  batch.y[i] = position.y();
+  batch.z[i] = position.z();
+  batch.dx[i] = direction.x();
+  batch.dy[i] = direction.y();
+  batch.dz[i] = direction.z();
+  batch.bin[i] = GetBin(energy);
+  batch.layer[i] = layer;
+  batch.alive[i] = 1;
+  batch.first[i] = 1;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4OpBoundaryProcessStatus OpticalStack::Fresnel(PhotonBatch& batch, std::size_t i,
+                                                G4int axis, G4double n1,
+                                                G4double n2) const
+{
+  G4double* dir[3] = { &batch.dx[i], &batch.dy[i], &batch.dz[i] };
+  const G4double cosI = std::abs(*dir[axis]);
+  const G4double eta = n1 / n2;
+  const G4double sinT2 = eta * eta * (1. - cosI * cosI);
+  if(sinT2 >= 1.)
+  {
+    *dir[axis] = -*dir[axis];
+    return TotalInternalReflection;
+  }
+
+  // average of the s and p reflectances
+  const G4double cosT = std::sqrt(1. - sinT2);
+  const G4double rs = (n1 * cosI - n2 * cosT) / (n1 * cosI + n2 * cosT);
+  const G4double rp = (n1 * cosT - n2 * cosI) / (n1 * cosT + n2 * cosI);
+  if(G4UniformRand() < 0.5 * (rs * rs + rp * rp))
+  {
+    *dir[axis] = -*dir[axis];
+    return FresnelReflection;
+  }
+
+  const G4double sign = *dir[axis] > 0. ? 1. : -1.;
+  for(G4int k = 0; k < 3; ++k)
+  {
+    *dir[k] = k == axis ? sign * cosT : eta * *dir[k];
+  }
+  return FresnelRefraction;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OpticalStack::Trace(PhotonBatch& batch, RayTraceTally& tally) const
+{
+  constexpr std::size_t kSize = PhotonBatch::kSize;
+  const std::size_t n = batch.size;
+  alignas(64) std::array<G4double, kSize> wallDist;
+  alignas(64) std::array<G4double, kSize> absDist;
+  alignas(64) std::array<G4double, kSize> rayDist;
+  alignas(64) std::array<G4double, 2 * kSize> random;
+  std::array<G4int, kSize> wallAxis;
+  CLHEP::HepRandomEngine* engine = G4Random::getTheEngine();
+
+  std::size_t nAlive = n;
+  tally.photons += n;
+  for(G4int step = 0; step < kMaxSteps && nAlive > 0; ++step)
+  {
+    // distance to the faces of the current layer box
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      const Layer& layer = fLayers[batch.layer[i]];
+      const G4double pos[3] = { batch.x[i], batch.y[i], batch.z[i] };
+      const G4double dir[3] = { batch.dx[i], batch.dy[i], batch.dz[i] };
+      G4double best = kInfinity;
+      G4int axis = 2;
+      for(G4int k = 0; k < 3; ++k)
+      {
+        const G4double face = dir[k] > 0. ? layer.upper[k] : layer.lower[k];
+        const G4double t = dir[k] != 0. ? (face - pos[k]) / dir[k] : kInfinity;
+        axis = t < best ? k : axis;
+        best = std::min(best, t);
+      }
+      wallDist[i] = std::max(best, 0.);
+      wallAxis[i] = axis;
+    }
+
+    // sampled distances to bulk absorption and Rayleigh scattering
+    engine->flatArray(static_cast<G4int>(2 * n), random.data());
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      absDist[i] = -GetProperty(batch.layer[i], batch.bin[i], kAbsLength)
+                   * std::log(random[2 * i]);
+      rayDist[i] = -GetProperty(batch.layer[i], batch.bin[i], kRayleigh)
+                   * std::log(random[2 * i + 1]);
+    }
+
+    // move the live photons to the nearest of the three
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      const G4double s =
+        batch.alive[i] * std::min(wallDist[i], std::min(absDist[i], rayDist[i]));
+      batch.x[i] += s * batch.dx[i];
+      batch.y[i] += s * batch.dy[i];
+      batch.z[i] += s * batch.dz[i];
+    }
+
+    // interactions, one photon at a time
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      if(!batch.alive[i]) continue;
+
+      if(absDist[i] < wallDist[i] && absDist[i] <= rayDist[i])
+      {
+        tally.absorbed += 1.;
+        if(batch.first[i]) tally.absorbedPrior += 1.;
+        batch.alive[i] = 0;
+        --nAlive;
+        continue;
+      }
+      if(rayDist[i] < wallDist[i])
+      {
+        G4double cosTheta = 0.;
+        do
+        {
+          cosTheta = 2. * G4UniformRand() - 1.;
+        } while(2. * G4UniformRand() > 1. + cosTheta * cosTheta);
+        const G4double sinTheta = std::sqrt(1. - cosTheta * cosTheta);
+        const G4double phi = twopi * G4UniformRand();
+        G4ThreeVector dir(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+        dir.rotateUz(G4ThreeVector(batch.dx[i], batch.dy[i], batch.dz[i]));
+        batch.dx[i] = dir.x();
+        batch.dy[i] = dir.y();
+        batch.dz[i] = dir.z();
+        tally.rayleigh += 1.;
+        continue;
+      }
+
+      // on a face of the layer box
+      const G4int l = batch.layer[i];
+      const Layer& layer = fLayers[l];
+      const G4int bin = batch.bin[i];
+      const G4int axis = wallAxis[i];
+      G4double* pos[3] = { &batch.x[i], &batch.y[i], &batch.z[i] };
+      G4double* dir[3] = { &batch.dx[i], &batch.dy[i], &batch.dz[i] };
+      const G4bool up = *dir[axis] > 0.;
+      *pos[axis] = up ? layer.upper[axis] : layer.lower[axis];
+      const G4double n1 = GetProperty(l, bin, kRindex);
+
+      G4OpBoundaryProcessStatus status = Undefined;
+      G4bool stopped = false;
+      if(axis == 2)
+      {
+        // into the next layer, or the world if none touches here
+        G4int next = up ? layer.above : layer.below;
+        if(next >= 0)
+        {
+          const Layer& other = fLayers[next];
+          if(*pos[0] < other.lower[0] || *pos[0] > other.upper[0] ||
+             *pos[1] < other.lower[1] || *pos[1] > other.upper[1])
+          {
+            next = -1;
+          }
+        }
+        const G4double n2 = next >= 0 ? GetProperty(next, bin, kRindex) : fWorldRindex[bin];
+        if(n2 <= 0.)
+        {
+          status = NoRINDEX;
+          tally.surface += 1.;
+          stopped = true;
+        }
+        else
+        {
+          status = Fresnel(batch, i, axis, n1, n2);
+          if(status == FresnelRefraction)
+          {
+            if(next < 0)
+            {
+              tally.escaped += 1.;
+              stopped = true;
+            }
+            else
+            {
+              batch.layer[i] = next;
+              *pos[2] = up ? fLayers[next].lower[2] : fLayers[next].upper[2];
+              if(fLayers[next].detector)
+              {
+                tally.detected += 1.;
+                stopped = true;
+              }
+            }
+          }
+        }
+      }
+      else if(layer.metal)
+      {
+        if(G4UniformRand() < fSurfaceReflectivity[l * fNBins + bin])
+        {
+          *dir[axis] = -*dir[axis];
+          status = SpikeReflection;
+        }
+        else
+        {
+          status = Absorption;
+          tally.surface += 1.;
+          stopped = true;
+        }
+      }
+      else if(fWorldRindex[bin] <= 0.)
+      {
+        status = NoRINDEX;
+        tally.surface += 1.;
+        stopped = true;
+      }
+      else
+      {
+        const G4double incident[3] = { *dir[0], *dir[1], *dir[2] };
+        status = Fresnel(batch, i, axis, n1, fWorldRindex[bin]);
+        if(status == FresnelRefraction)
+        {
+          // a reflector outside this side sends it back the way it came
+          const G4int r = layer.reflector;
+          if(r >= 0 && *pos[2] >= fReflectors[r].zLow && *pos[2] <= fReflectors[r].zHigh &&
+             G4UniformRand() < fReflectorReflectivity[r * fNBins + bin])
+          {
+            for(G4int k = 0; k < 3; ++k) *dir[k] = incident[k];
+            *dir[axis] = -*dir[axis];
+          }
+          else
+          {
+            tally.escaped += 1.;
+            stopped = true;
+          }
+        }
+      }
+
+      if(batch.first[i])
+      {
+        tally.firstStatus[status] += 1.;
+        batch.first[i] = 0;
+      }
+      if(stopped)
+      {
+        batch.alive[i] = 0;
+        --nAlive;
+      }
+    }
+  }
+  tally.lost += nAlive;
+  batch.Clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OpticalStack::Print() const
+{
+  const G4int mid = fNBins / 2;
+  G4cout << " Optical stack (" << fLayers.size() << " layers, " << fNBins
+         << " energy bins " << fEnergyMin / eV << " - " << fEnergyMax / eV
+         << " eV):" << G4endl;
+  for(std::size_t l = 0; l < fLayers.size(); ++l)
+  {
+    const Layer& layer = fLayers[l];
+    G4cout << "  " << layer.name << "  z " << layer.lower[2] / mm << " - "
+           << layer.upper[2] / mm << " mm, " << (layer.upper[0] - layer.lower[0]) / mm
+           << " x " << (layer.upper[1] - layer.lower[1]) / mm << " mm";
+    if(layer.opaque)
+      G4cout << ", opaque";
+    else
+      G4cout << ", n = " << GetProperty(static_cast<G4int>(l), mid, kRindex);
+    if(layer.metal) G4cout << ", metal sides";
+    if(layer.reflector >= 0) G4cout << ", reflector";
+    if(layer.detector) G4cout << ", detector";
+    G4cout << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
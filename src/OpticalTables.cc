@@ -0,0 +1,161 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/src/OpticalTables.cc
+/// \brief Implementation of the OpticalTables class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "OpticalTables.hh"
+
+#include "G4MaterialPropertiesTable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <iomanip>
+
+namespace
+{
+// the property names, in the order of OpticalTables::Property
+const char* const kPropertyNames[OpticalTables::kNProperties] = {
+  "RINDEX", "ABSLENGTH", "GROUPVEL", "RAYLEIGH", "WLSABSLENGTH", "WLSABSLENGTH2"
+};
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool UniformTable::Build(const G4MaterialPropertyVector& source, G4double tolerance,
+                           G4int maxBins)
+{
+  fNSourcePoints = source.GetVectorLength();
+  fValues.clear();
+  if(fNSourcePoints == 0) return true;
+
+  fEnergyMin = source.GetMinEnergy();
+  fEnergyMax = source.GetMaxEnergy();
+  G4double scale = 0.;
+  for(std::size_t k = 0; k < fNSourcePoints; ++k)
+  {
+    scale = std::max(scale, std::abs(source[k]));
+  }
+
+  // a single point, or all points at one energy: two equal bins
+  const G4bool range = fEnergyMax > fEnergyMin;
+  G4int nBins = range ? 64 : 2;
+  while(true)
+  {
+    const G4double step = range ? (fEnergyMax - fEnergyMin) / (nBins - 1) : 1.;
+    fValues.resize(nBins);
+    for(G4int i = 0; i < nBins; ++i)
+    {
+      fValues[i] = source.Value(fEnergyMin + i * step);
+    }
+    fInvStep = 1. / step;
+    fLast = nBins - 1;
+
+    // both are piecewise linear, so the difference peaks at a breakpoint;
+    // the grid points are exact, which leaves the source points
+    fMaxDeviation = 0.;
+    for(std::size_t k = 0; k < fNSourcePoints; ++k)
+    {
+      fMaxDeviation =
+        std::max(fMaxDeviation, std::abs(Value(source.Energy(k)) - source[k]));
+    }
+    const G4bool converged = fMaxDeviation <= tolerance * scale;
+    if(converged || !range || nBins >= maxBins) return converged;
+    nBins = std::min(2 * nBins, maxBins);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool OpticalTables::Has(Property property) const
+{
+  for(std::size_t i = property; i < fTables.size(); i += kNProperties)
+  {
+    if(fTables[i].IsValid()) return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OpticalTables::Build()
+{
+  const G4MaterialTable* materials = G4Material::GetMaterialTable();
+  fTables.assign(materials->size() * kNProperties, UniformTable());
+  fMaterialNames.assign(materials->size(), "");
+  for(const G4Material* material : *materials)
+  {
+    fMaterialNames[material->GetIndex()] = material->GetName();
+    const G4MaterialPropertiesTable* mpt = material->GetMaterialPropertiesTable();
+    if(!mpt) continue;
+    for(G4int p = 0; p < kNProperties; ++p)
+    {
+      const G4MaterialPropertyVector* source = mpt->GetProperty(kPropertyNames[p]);
+      UniformTable& table = fTables[material->GetIndex() * kNProperties + p];
+      if(source && !table.Build(*source))
+      {
+        G4ExceptionDescription ed;
+        ed << material->GetName() << " " << kPropertyNames[p] << ": max deviation "
+           << table.GetMaxDeviation() << " with " << table.GetNBins()
+           << " bins is above the tolerance.";
+        G4Exception("OpticalTables::Build", "OpNovice2_012", JustWarning, ed);
+      }
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OpticalTables::Dump(G4bool values) const
+{
+  G4cout << "Uniform optical property tables:" << G4endl;
+  for(std::size_t m = 0; m < fMaterialNames.size(); ++m)
+  {
+    for(G4int p = 0; p < kNProperties; ++p)
+    {
+      const UniformTable& table = fTables[m * kNProperties + p];
+      if(!table.IsValid()) continue;
+      G4cout << "  " << fMaterialNames[m] << " " << kPropertyNames[p] << ": "
+             << table.GetNSourcePoints() << " points -> " << table.GetNBins()
+             << " bins, " << table.GetEnergyMin() / eV << " - "
+             << table.GetEnergyMax() / eV << " eV, max deviation "
+             << table.GetMaxDeviation() << G4endl;
+      if(!values) continue;
+
+      const G4double step = table.GetNBins() > 1
+        ? (table.GetEnergyMax() - table.GetEnergyMin()) / (table.GetNBins() - 1) : 0.;
+      for(std::size_t i = 0; i < table.GetNBins(); ++i)
+      {
+        G4cout << "    " << std::setw(10) << (table.GetEnergyMin() + i * step) / eV
+               << " eV  " << table.GetBinValue(i) << G4endl;
+      }
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -35,6 +35,8 @@
 #include "PrimaryGeneratorMessenger.hh"
 #include "G4Event.hh"
 #include "G4OpticalPhoton.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
@@ -54,9 +56,6 @@
 // Ǝˈʒũ_
 //#define RANDAM
 
-// ÓIoϐ̒`Fl 0.0 Ƃ
-G4double PrimaryGeneratorAction::fGlobalOriginShiftY = 0.0;
-
 //////////////////////////////////////////////////////////////////////////////////////////
 // PrimaryGeneratorAction RXgN^
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -65,15 +64,23 @@ PrimaryGeneratorAction::PrimaryGeneratorAction()
 {
 	G4int n_particle = 1;
 	fParticleGun = new G4ParticleGun(n_particle);
+	fGunMessenger = new PrimaryGeneratorMessenger(this);
 }
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
 	delete fParticleGun;
+	delete fGunMessenger;
 }
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
+	if (fLightMapMode)
+	{
+		GenerateLightMapPhotons(anEvent);
+		return;
+	}
+
 	G4double particleEnergy = 0.0;
 
 
@@ -84,12 +91,14 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 	G4ThreeVector originShift(randomX, randomY, 0.0 * mm);
 	G4ThreeVector position(0.0 * mm, 0.0 * mm, 0.0 * mm);
 #else
-	G4ThreeVector originShift(10.0 * mm, GetGlobalOriginShiftY() * mm, 0.0 * mm);
+	G4ThreeVector originShift = fRunParameters.GetSourceOrigin(anEvent->GetEventID());
 	G4ThreeVector position(0.0 * mm, 0.0 * mm, 0.0 * mm);
 #endif
 
 	// ŁACxgԍ0̂ƂoriginShifẗʒuOói1 run̍ŏ̃Cxĝ݁j
-	if (anEvent->GetEventID() == 0) {
+	// and at the first event of each scan point
+	if (anEvent->GetEventID() % fRunParameters.eventsPerPoint == 0
+		&& (anEvent->GetEventID() == 0 || fRunParameters.GetScanPoint(anEvent->GetEventID()) >= 0)) {
 		G4cout << "Origin shift position: ("
 			<< originShift.x() / mm << ", "
 			<< originShift.y() / mm << ", "
@@ -163,20 +172,39 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 
 #endif
 
+	// /opnovice2/run/sourceEnergy
+	if (fRunParameters.sourceEnergy >= 0.)
+	{
+		particleEnergy = fRunParameters.sourceEnergy;
+	}
+
 	// **ʂ̐ݒ**
 	fParticleGun->SetParticleEnergy(particleEnergy);
 	fParticleGun->SetParticlePosition(position);
 
 
 	// **Iȕˁi4Εˁj**
-	G4double cosTheta = 1.0 - 2.0 * G4UniformRand();
-	G4double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
-	G4double phi = 2.0 * CLHEP::pi * G4UniformRand();
-
-	G4double dx = sinTheta * std::cos(phi);
-	G4double dy = sinTheta * std::sin(phi);
-	G4double dz = cosTheta;
-	fParticleGun->SetParticleMomentumDirection(G4ThreeVector(dx, dy, dz));
+	// /opnovice2/gun/biasCone: preferably towards the Tank, with the weight
+	// of the direction. An ion at rest is not biased here, its decay
+	// products are (StackingAction).
+	G4ThreeVector direction;
+	G4double weight = 1.;
+	if (fRunParameters.sourceDirection == SourceDirection::Beam)
+	{
+		direction.set(0., 0., -1.);
+	}
+	else if (particleEnergy > 0.)
+	{
+		weight = fDirectionBias.Sample(position, direction);
+	}
+	else
+	{
+		G4double cosTheta = 1.0 - 2.0 * G4UniformRand();
+		G4double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
+		G4double phi = 2.0 * CLHEP::pi * G4UniformRand();
+		direction.set(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+	}
+	fParticleGun->SetParticleMomentumDirection(direction);
 
 	/*
 	// Œ (0, 0, -1) ݒ
@@ -186,6 +214,8 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 
 	// ŃvC}_𐶐
 	fParticleGun->GeneratePrimaryVertex(anEvent);
+	// becomes the track weight, picked up by TrackInformation
+	anEvent->GetPrimaryVertex(anEvent->GetNumberOfPrimaryVertex() - 1)->SetWeight(weight);
 
 
 	/*
@@ -197,6 +227,79 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 }
 
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::BuildLightMap(const DetectorConstruction* detector,
+	const G4VPhysicalVolume* world)
+{
+	fLightMap.Build(detector, world);
+	if (fLightMap.GetNCells() == 0)
+	{
+		G4ExceptionDescription ed;
+		ed << "No scintillator with an emission spectrum was found; the light "
+			"map run generates no photons.";
+		G4Exception("PrimaryGeneratorAction::BuildLightMap", "OpNovice2_005",
+			JustWarning, ed);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PrimaryGeneratorAction::LoadLightMap()
+{
+	const G4String fileName = fLightMap.GetFileName();
+	if (fLightMap.GetNCells() > 0 && fLightMap.Read(fileName))
+	{
+		return true;
+	}
+
+	G4ExceptionDescription ed;
+	ed << "No light map " << fileName << " for the current geometry, grid and "
+		"optical properties;" << G4endl
+		<< "run /opnovice2/lightmap/enable first. Optical photons are tracked.";
+	G4Exception("PrimaryGeneratorAction::LoadLightMap", "OpNovice2_006",
+		JustWarning, ed);
+	return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::GenerateLightMapPhotons(G4Event* anEvent)
+{
+	const G4int nCells = fLightMap.GetNCells();
+	if (nCells == 0) return;
+
+	// Run::RecordEvent() tallies the event in the same cell
+	const G4int cell = anEvent->GetEventID() % nCells;
+	G4ParticleDefinition* opticalphoton = G4OpticalPhoton::OpticalPhotonDefinition();
+
+	for (G4int i = 0; i < fLightMapPhotons; ++i)
+	{
+		G4ThreeVector position;
+		G4double energy = 0.;
+		// cells outside the solid emit nothing
+		if (!fLightMap.SampleEmission(cell, position, energy)) return;
+
+		G4double cosTheta = 1.0 - 2.0 * G4UniformRand();
+		G4double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
+		G4double phi = 2.0 * CLHEP::pi * G4UniformRand();
+		G4ThreeVector direction(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+
+		// random linear polarization perpendicular to the direction
+		G4ThreeVector polarization = direction.orthogonal().unit();
+		polarization.rotate(2.0 * CLHEP::pi * G4UniformRand(), direction);
+
+		auto photon = new G4PrimaryParticle(opticalphoton);
+		photon->SetMomentumDirection(direction);
+		photon->SetKineticEnergy(energy);
+		photon->SetPolarization(polarization);
+
+		auto vertex = new G4PrimaryVertex(position, 0.);
+		vertex->SetPrimary(photon);
+		anEvent->AddPrimaryVertex(vertex);
+	}
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void PrimaryGeneratorAction::SetOptPhotonPolar()
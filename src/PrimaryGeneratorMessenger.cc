@@ -34,10 +34,16 @@
 
 #include "PrimaryGeneratorAction.hh"
 #include "G4UIdirectory.hh"
+#include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
 #include "G4SystemOfUnits.hh"
 
+#include <sstream>
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(
@@ -63,6 +69,55 @@ PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(
     "Set direction of each primary particle randomly.");
   fRandomDirectionCmd->SetDefaultValue(true);
   fRandomDirectionCmd->AvailableForStates(G4State_Idle, G4State_PreInit);
+
+  fBiasConeCmd = new G4UIcmdWithADouble("/opnovice2/gun/biasCone", this);
+  fBiasConeCmd->SetGuidance(
+    "Fraction of the source directions drawn in the cone around the Tank");
+  fBiasConeCmd->SetGuidance(
+    "(0 = isotropic). Primaries and decay products are weighted so that");
+  fBiasConeCmd->SetGuidance("the counts in Run stay unbiased.");
+  fBiasConeCmd->SetParameterName("fraction", false);
+  fBiasConeCmd->SetRange("fraction >= 0 && fraction < 1");
+  fBiasConeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fLightMapDir = new G4UIdirectory("/opnovice2/lightmap/");
+  fLightMapDir->SetGuidance("Light collection efficiency map runs");
+
+  fLightMapCmd = new G4UIcmdWithABool("/opnovice2/lightmap/enable", this);
+  fLightMapCmd->SetGuidance(
+    "Replace the primaries by optical photons emitted on a grid over the");
+  fLightMapCmd->SetGuidance(
+    "scintillators; event N fills cell N % (number of cells). The map is");
+  fLightMapCmd->SetGuidance("written to lce_<hash>.bin at the end of run.");
+  fLightMapCmd->SetDefaultValue(true);
+  fLightMapCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fLightMapGridCmd = new G4UIcommand("/opnovice2/lightmap/grid", this);
+  fLightMapGridCmd->SetGuidance(
+    "Number of cells along x, y and z of each scintillator");
+  for(const char* axis : { "nx", "ny", "nz" })
+  {
+    auto param = new G4UIparameter(axis, 'i', false);
+    param->SetParameterRange(G4String(axis) + " > 0");
+    fLightMapGridCmd->SetParameter(param);
+  }
+  fLightMapGridCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fLightMapPhotonsCmd =
+    new G4UIcmdWithAnInteger("/opnovice2/lightmap/photons", this);
+  fLightMapPhotonsCmd->SetGuidance("Number of photons emitted per event");
+  fLightMapPhotonsCmd->SetParameterName("photons", false);
+  fLightMapPhotonsCmd->SetRange("photons > 0");
+  fLightMapPhotonsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fLightMapFastCmd = new G4UIcmdWithABool("/opnovice2/lightmap/fast", this);
+  fLightMapFastCmd->SetGuidance(
+    "Do not track scintillation photons: each one is detected with the");
+  fLightMapFastCmd->SetGuidance(
+    "efficiency of its map cell. Needs the map made with the same grid;");
+  fLightMapFastCmd->SetGuidance("without it the photons are tracked.");
+  fLightMapFastCmd->SetDefaultValue(true);
+  fLightMapFastCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -72,6 +127,12 @@ PrimaryGeneratorMessenger::~PrimaryGeneratorMessenger()
   delete fPolarCmd;
   delete fGunDir;
   delete fRandomDirectionCmd;
+  delete fBiasConeCmd;
+  delete fLightMapCmd;
+  delete fLightMapGridCmd;
+  delete fLightMapPhotonsCmd;
+  delete fLightMapFastCmd;
+  delete fLightMapDir;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -95,6 +156,31 @@ void PrimaryGeneratorMessenger::SetNewValue(G4UIcommand* command,
   {
     fPrimaryAction->SetRandomDirection(true);
   }
+  else if(command == fBiasConeCmd)
+  {
+    fPrimaryAction->GetDirectionBias().SetFraction(
+      fBiasConeCmd->GetNewDoubleValue(newValue));
+  }
+  else if(command == fLightMapCmd)
+  {
+    fPrimaryAction->SetLightMapMode(fLightMapCmd->GetNewBoolValue(newValue));
+  }
+  else if(command == fLightMapGridCmd)
+  {
+    std::istringstream is(newValue);
+    G4int nx = 1, ny = 1, nz = 1;
+    is >> nx >> ny >> nz;
+    fPrimaryAction->SetLightMapGrid(nx, ny, nz);
+  }
+  else if(command == fLightMapFastCmd)
+  {
+    fPrimaryAction->SetLightMapFast(fLightMapFastCmd->GetNewBoolValue(newValue));
+  }
+  else if(command == fLightMapPhotonsCmd)
+  {
+    fPrimaryAction->SetLightMapPhotons(
+      fLightMapPhotonsCmd->GetNewIntValue(newValue));
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
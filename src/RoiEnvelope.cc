@@ -0,0 +1,164 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/src/RoiEnvelope.cc
+/// \brief Implementation of the RoiEnvelope class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "RoiEnvelope.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+#include "G4Transform3D.hh"
+#include "G4UnitsTable.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RoiEnvelope::SetKill(const G4String& particle, G4bool kill)
+{
+  if(particle == "all")
+  {
+    fKillDefault = kill;
+    fKillByName.clear();
+    return;
+  }
+  fKillByName[particle] = kill;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RoiEnvelope::Build(const G4VPhysicalVolume* world)
+{
+  fKill.clear();
+  const G4LogicalVolume* worldLV = world ? world->GetLogicalVolume() : nullptr;
+  if(!worldLV || worldLV->GetNoDaughters() == 0) return false;
+
+  const G4double big = std::numeric_limits<G4double>::max();
+  fLower.set(big, big, big);
+  fUpper.set(-big, -big, -big);
+  for(std::size_t i = 0; i < worldLV->GetNoDaughters(); ++i)
+  {
+    // the daughters of the world enclose everything placed below them
+    const G4VPhysicalVolume* daughter = worldLV->GetDaughter(i);
+    G4ThreeVector lower, upper;
+    daughter->GetLogicalVolume()->GetSolid()->BoundingLimits(lower, upper);
+    const G4Transform3D toWorld(daughter->GetObjectRotationValue(),
+                                daughter->GetObjectTranslation());
+    for(G4int c = 0; c < 8; ++c)
+    {
+      const HepGeom::Point3D<G4double> local((c & 1) ? upper.x() : lower.x(),
+                                             (c & 2) ? upper.y() : lower.y(),
+                                             (c & 4) ? upper.z() : lower.z());
+      const G4ThreeVector corner = toWorld * local;
+      fLower.set(std::min(fLower.x(), corner.x()),
+                 std::min(fLower.y(), corner.y()),
+                 std::min(fLower.z(), corner.z()));
+      fUpper.set(std::max(fUpper.x(), corner.x()),
+                 std::max(fUpper.y(), corner.y()),
+                 std::max(fUpper.z(), corner.z()));
+    }
+  }
+  const G4ThreeVector margin(fMargin, fMargin, fMargin);
+  fLower -= margin;
+  fUpper += margin;
+
+  // policies by particle instance ID; particles created later (ions) get
+  // the default
+  G4ParticleTable::G4PTblDicIterator* it =
+    G4ParticleTable::GetParticleTable()->GetIterator();
+  it->reset();
+  while((*it)())
+  {
+    const G4ParticleDefinition* particle = it->value();
+    const auto id = static_cast<std::size_t>(particle->GetInstanceID());
+    if(id >= fKill.size()) fKill.resize(id + 1, fKillDefault);
+    auto entry = fKillByName.find(particle->GetParticleName());
+    fKill[id] = entry != fKillByName.end() ? entry->second : fKillDefault;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RoiEnvelope::Kills(const G4ParticleDefinition* particle) const
+{
+  const auto id = static_cast<std::size_t>(particle->GetInstanceID());
+  return id < fKill.size() ? fKill[id] : fKillDefault;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool RoiEnvelope::IsEscaping(const G4ThreeVector& position,
+                               const G4ThreeVector& direction) const
+{
+  // slab test of the forward ray against the box; inside means a hit
+  G4double tMin = 0.;
+  G4double tMax = std::numeric_limits<G4double>::max();
+  for(G4int i = 0; i < 3; ++i)
+  {
+    const G4double p = position[i];
+    const G4double d = direction[i];
+    if(std::abs(d) < 1.e-12)
+    {
+      if(p < fLower[i] || p > fUpper[i]) return true;
+      continue;
+    }
+    G4double t1 = (fLower[i] - p) / d;
+    G4double t2 = (fUpper[i] - p) / d;
+    if(t1 > t2) std::swap(t1, t2);
+    tMin = std::max(tMin, t1);
+    tMax = std::min(tMax, t2);
+    if(tMin > tMax) return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RoiEnvelope::Print() const
+{
+  G4cout << " ROI envelope: " << G4BestUnit(fLower, "Length") << " to "
+         << G4BestUnit(fUpper, "Length") << " (margin "
+         << G4BestUnit(fMargin, "Length") << "), killing "
+         << (fKillDefault ? "all particles" : "no particles");
+  G4String exceptions;
+  for(const auto& entry : fKillByName)
+  {
+    if(entry.second != fKillDefault) exceptions += " " + entry.first;
+  }
+  if(!exceptions.empty()) G4cout << " except" << exceptions;
+  G4cout << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -33,51 +33,61 @@
 #include "Run.hh"
 #include "DetectorConstruction.hh"
 #include "HistoManager.hh"
+#include "G4Event.hh"
+#include "G4HCofThisEvent.hh"
 #include "G4OpBoundaryProcess.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4SDManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4UnitsTable.hh"
 #include <iomanip>
 #include <numeric>
 #include <fstream>
 #include <iostream>
+#include <limits>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 Run::Run()
 
-	: G4Run(), fPhotonCount(0), fPhotonCountZnSaWorld(0), fPhotonCountZnSPlastic(0), fPhotonCountPlasticZnS(0), outputFileName("default_output.txt")
+	: G4Run(), outputFileName("default_output.txt")
 {
-	fBoundaryProcs.assign(43, 0);
+	fBoundaryProcs.assign(kNBoundaryStatus, Tally());
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 void Run::AddPhotonCount()
 {
-	fPhotonCount++;
-	//std::cout << fPhotonCount << std::endl;
+	fTallies[kDetected].Add();
 }
 
-void Run::AddPhotonCountZW()
+void Run::AddPhotonArrival(G4double time, G4double weight)
 {
-	fPhotonCountZnSaWorld++;
-}
-
-void Run::AddPhotonCountZP()
-{
-	fPhotonCountZnSPlastic++;
+	fTallies[kDetected].Add(weight);
+	if (fLightMapRun)
+	{
+		fEventArrivals += weight;
+		fEventTimeSum += weight * time;
+		fEventTimeSum2 += weight * time * time;
+	}
 }
 
-void Run::AddPhotonCountPZ()
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void Run::AddBoundaryStatus(G4OpBoundaryProcessStatus status, G4double w)
 {
-	fPhotonCountPlasticZnS++;
+	if (status > Undefined && static_cast<std::size_t>(status) < kNBoundaryStatus)
+	{
+		fBoundaryProcs[status].Add(w);
+	}
+	else
+	{
+		G4cout << "theStatus: " << status << " was none of the above." << G4endl;
+	}
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 void Run::ResetPhotonCount()
 {
-	fPhotonCount = 0;
-	fPhotonCountZnSaWorld = 0;
-	fPhotonCountZnSPlastic = 0;
-	fPhotonCountPlasticZnS = 0;
+	fTallies[kDetected] = Tally();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -91,6 +101,91 @@ void Run::SetPrimary(G4ParticleDefinition* particle, G4double energy,
 	//ResetPhotonCount();
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void Run::SetParameters(const RunParameters& params)
+{
+	fParameters = params;
+	fScanPoints.assign(params.scanOrigins.size(), ScanPointTally());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void Run::SetLightMap(const LightMap& map)
+{
+	fLightMap = map;
+	fLightMap.Reset();
+	fLightMapRun = fLightMap.GetNCells() > 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void Run::RecordEvent(const G4Event* event)
+{
+	if (fLightMapRun)
+	{
+		// PrimaryGeneratorAction emits the photons of event N in cell
+		// N % nCells, one primary per photon
+		G4double emitted = 0.;
+		for (G4PrimaryVertex* vertex = event->GetPrimaryVertex(); vertex;
+			vertex = vertex->GetNext())
+		{
+			emitted += vertex->GetNumberOfParticle();
+		}
+		fLightMap.AddEvent(event->GetEventID() % fLightMap.GetNCells(), emitted,
+			fEventArrivals, fEventTimeSum, fEventTimeSum2);
+		fEventArrivals = 0.;
+		fEventTimeSum = 0.;
+		fEventTimeSum2 = 0.;
+	}
+
+	// the event's share of the tallies goes to its scan point as well
+	const G4int point = fParameters.GetScanPoint(event->GetEventID());
+	ScanPointTally* scanPoint = point >= 0 ? &fScanPoints[point] : nullptr;
+	if (scanPoint)
+	{
+		scanPoint->events += 1;
+		scanPoint->created.Add(fTallies[kScintillation].event);
+		scanPoint->detected.Add(fTallies[kDetected].event);
+		scanPoint->created.EndOfEvent();
+		scanPoint->detected.EndOfEvent();
+	}
+
+	for (auto& tally : fTallies)
+	{
+		tally.EndOfEvent();
+	}
+	for (auto& tally : fBoundaryProcs)
+	{
+		tally.EndOfEvent();
+	}
+
+	if (!fTankHCIDsResolved)
+	{
+		G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+		fTankHCIDs[TankSD::kAlpha] = sdManager->GetCollectionID("TankSD/alpha");
+		fTankHCIDs[TankSD::kBeta] = sdManager->GetCollectionID("TankSD/beta");
+		fTankHCIDs[TankSD::kGamma] = sdManager->GetCollectionID("TankSD/gamma");
+		fTankHCIDsResolved = true;
+	}
+
+	G4HCofThisEvent* hce = event->GetHCofThisEvent();
+	if (hce)
+	{
+		std::array<G4double*, TankSD::kNSpecies> counts = { &fAlphaCount, &fBetaCount, &fGammaCount };
+		for (G4int i = 0; i < TankSD::kNSpecies; ++i)
+		{
+			if (fTankHCIDs[i] < 0) continue;
+			auto hitsMap = static_cast<G4THitsMap<G4double>*>(hce->GetHC(fTankHCIDs[i]));
+			if (!hitsMap) continue;
+			for (const auto& entry : *hitsMap->GetMap())
+			{
+				*counts[i] += *entry.second;
+				if (scanPoint) scanPoint->tank[i] += *entry.second;
+			}
+		}
+	}
+
+	G4Run::RecordEvent(event);
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 void Run::Merge(const G4Run* run)
 {
@@ -109,23 +204,47 @@ void Run::Merge(const G4Run* run)
 	fWLS2AbsorptionEnergy += localRun->fWLS2AbsorptionEnergy;
 	fWLS2EmissionEnergy += localRun->fWLS2EmissionEnergy;
 
-	fCerenkovCount += localRun->fCerenkovCount;
-	fScintCount += localRun->fScintCount;
-	fWLSAbsorptionCount += localRun->fWLSAbsorptionCount;
-	fWLSEmissionCount += localRun->fWLSEmissionCount;
-	fWLS2AbsorptionCount += localRun->fWLS2AbsorptionCount;
-	fWLS2EmissionCount += localRun->fWLS2EmissionCount;
-	fRayleighCount += localRun->fRayleighCount;
+	for (std::size_t i = 0; i < fTallies.size(); ++i)
+	{
+		fTallies[i].Merge(localRun->fTallies[i]);
+	}
+
+	fGroupVelocityChecks += localRun->fGroupVelocityChecks;
+	fGroupVelocityViolations += localRun->fGroupVelocityViolations;
+	fGroupVelocityTableDeviation = std::max(fGroupVelocityTableDeviation,
+		localRun->fGroupVelocityTableDeviation);
 
-	fTotalSurface += localRun->fTotalSurface;
+	for (std::size_t i = 0; i < fSpectralCuts.size(); ++i)
+	{
+		fSpectralCuts[i] += localRun->fSpectralCuts[i];
+	}
+
+	fRayTrace.Merge(localRun->fRayTrace);
+
+	if (fScanPoints.size() < localRun->fScanPoints.size())
+	{
+		fScanPoints.resize(localRun->fScanPoints.size());
+	}
+	for (std::size_t i = 0; i < localRun->fScanPoints.size(); ++i)
+	{
+		const ScanPointTally& other = localRun->fScanPoints[i];
+		ScanPointTally& scanPoint = fScanPoints[i];
+		scanPoint.events += other.events;
+		scanPoint.created.Merge(other.created);
+		scanPoint.detected.Merge(other.detected);
+		for (G4int j = 0; j < TankSD::kNSpecies; ++j)
+		{
+			scanPoint.tank[j] += other.tank[j];
+		}
+	}
 
-	fOpAbsorption += localRun->fOpAbsorption;
-	fOpAbsorptionPrior += localRun->fOpAbsorptionPrior;
+	for (const auto& entry : localRun->fRoiKills)
+	{
+		RoiKills& kills = fRoiKills[entry.first];
+		kills.tracks += entry.second.tracks;
+		kills.energy += entry.second.energy;
+	}
 
-	fPhotonCount += localRun->fPhotonCount;
-	fPhotonCountZnSaWorld += localRun->fPhotonCountZnSaWorld;
-	fPhotonCountZnSPlastic += localRun->fPhotonCountZnSPlastic;
-	fPhotonCountPlasticZnS += localRun->fPhotonCountPlasticZnS;
 
 	// eXbhŌvꂽ EẼJEg𓝍
 	fAlphaCount += localRun->fAlphaCount;
@@ -134,7 +253,13 @@ void Run::Merge(const G4Run* run)
 
 	for (size_t i = 0; i < fBoundaryProcs.size(); ++i)
 	{
-		fBoundaryProcs[i] += localRun->fBoundaryProcs[i];
+		fBoundaryProcs[i].Merge(localRun->fBoundaryProcs[i]);
+	}
+
+	if (localRun->fLightMapRun)
+	{
+		fLightMap.Merge(localRun->fLightMap);
+		fLightMapRun = true;
 	}
 
 	G4Run::Merge(run);
@@ -152,33 +277,93 @@ void Run::EndOfRun()
 		return;
 	}
 
+	// a light map run only produces the map
+	if (fLightMapRun)
+	{
+		const G4String mapFile = fLightMap.GetFileName();
+		G4cout << "-----------------------------------------------" << G4endl;
+		fLightMap.Print();
+		if (fLightMap.Write(mapFile))
+			G4cout << " Light map written to " << mapFile << G4endl;
+		else
+			G4cerr << "Error writing light map " << mapFile << G4endl;
+		G4cout << "-------------------------------------------------\n" << G4endl;
+		return;
+	}
+
 	auto TotNbofEvents = (G4double)numberOfEvent;
-	G4int detectedAlphas = GetAlphaCount();
-	G4int betaCount = GetBetaCount();
-	G4int gammaCount = GetGammaCount();
+	G4double betaCount = GetBetaCount();
+	G4double gammaCount = GetGammaCount();
 
 
 	if (numberOfEvent == 0) return;
 
-	G4double createdPhotons = fScintCount / TotNbofEvents;
-	G4double detectedPhotons = fPhotonCount;
+	// weighted sums; equal to the counts unless variance reduction is used
+	const Tally& scint = fTallies[kScintillation];
+	const Tally& detected = fTallies[kDetected];
+	G4double createdPhotons = scint.sum / TotNbofEvents;
+	G4double detectedPhotons = detected.sum;
 	G4double photonYieldPercentage = 0.0;
 
-	if (fScintCount != 0 && TotNbofEvents != 0) {
-		photonYieldPercentage = (static_cast<G4double>(fPhotonCount) / createdPhotons) * 100;
+	if (scint.sum != 0 && TotNbofEvents != 0) {
+		photonYieldPercentage = (detected.sum / createdPhotons) * 100;
 	}
 
 	G4cout << "-----------------------------------------------" << G4endl;
 	G4cout << "particles: " << fParticle->GetParticleName() << " with energy " << G4BestUnit(fEkin, "Energy") << "." << G4endl;
-	G4cout << "created photons : " << createdPhotons << G4endl;
-	G4cout << "detected photons: " << detectedPhotons << G4endl;
+	fParameters.Print();
+	G4cout << "created photons : " << createdPhotons << " +- "
+		<< scint.GetError(numberOfEvent) / TotNbofEvents << G4endl;
+	G4cout << "detected photons: " << detectedPhotons << " +- "
+		<< detected.GetError(numberOfEvent) << G4endl;
 	G4cout << "Final Alpha Count: " << fAlphaCount << G4endl;
 	G4cout << "Final Beta Count: " << betaCount << G4endl;
 	G4cout << "Final Gamma Count: " << gammaCount << G4endl;
+	if (fGroupVelocityChecks > 0)
+	{
+		G4cout << "Group velocity checks: " << fGroupVelocityChecks
+			<< ", violations: " << fGroupVelocityViolations
+			<< "; GROUPVEL table deviation: " << fGroupVelocityTableDeviation / (cm / ns)
+			<< " cm/ns" << G4endl;
+	}
+	if (fTallies[kTotalSurface].sum > 0.)
+	{
+		G4cout << "photons on the first surface: " << fTallies[kTotalSurface].sum
+			<< " +- " << fTallies[kTotalSurface].GetError(numberOfEvent) << G4endl;
+	}
+	if (fTallies[kOutOfGate].sum > 0.)
+	{
+		G4cout << "photons out of the time gate: " << fTallies[kOutOfGate].sum
+			<< " +- " << fTallies[kOutOfGate].GetError(numberOfEvent) << G4endl;
+	}
+	if (fSpectralCuts[kOutOfBand] + fSpectralCuts[kRouletted] + fSpectralCuts[kAccepted] > 0)
+	{
+		G4cout << "Quantum efficiency cut: " << fSpectralCuts[kOutOfBand]
+			<< " photons out of band, " << fSpectralCuts[kRouletted]
+			<< " rouletted, " << fSpectralCuts[kAccepted] << " tracked;"
+			<< " detected photons are photoelectrons" << G4endl;
+	}
+	if (!fRoiKills.empty())
+	{
+		G4cout << "Tracks killed outside the ROI envelope:" << G4endl;
+		for (const auto& entry : fRoiKills)
+		{
+			G4cout << "  " << entry.first << ": " << entry.second.tracks
+				<< " tracks, " << G4BestUnit(entry.second.energy, "Energy") << G4endl;
+		}
+	}
+	if (fRayTrace.photons > 0)
+	{
+		PrintRayTrace();
+	}
+	if (!fScanPoints.empty())
+	{
+		PrintScan();
+	}
 
 
-	if (fScintCount != 0 && TotNbofEvents != 0) {
-		photonYieldPercentage = (static_cast<G4double>(fPhotonCount) / (fScintCount / TotNbofEvents)) * 100;
+	if (scint.sum != 0 && TotNbofEvents != 0) {
+		photonYieldPercentage = (detected.sum / (scint.sum / TotNbofEvents)) * 100;
 	}
 	G4cout << std::fixed << std::setprecision(2) << "detection yields: " << photonYieldPercentage << " %" << G4endl;
 	G4cout << "-------------------------------------------------\n" << G4endl;
@@ -190,10 +375,103 @@ void Run::EndOfRun()
 		return;
 	}
 
-	outputFile << std::fixed << std::setprecision(2) << createdPhotons << " " << detectedPhotons << " " << photonYieldPercentage << " " << fAlphaCount << " " << betaCount << " " << gammaCount << std::endl;
+	// a farm process writes, for each run or point, the number of events,
+	// sum and sum2 of the created then of the detected photons and the Tank
+	// entries, at full precision; FarmDriver merges them into the usual line
+	if (fParameters.farmShard)
+	{
+		outputFile << std::defaultfloat << std::setprecision(std::numeric_limits<G4double>::max_digits10);
+		if (fScanPoints.empty())
+		{
+			outputFile << numberOfEvent << " " << scint.sum << " " << scint.sum2 << " " << detected.sum
+				<< " " << detected.sum2 << " " << fAlphaCount << " " << betaCount << " " << gammaCount << std::endl;
+		}
+		for (const auto& scanPoint : fScanPoints)
+		{
+			outputFile << scanPoint.events << " " << scanPoint.created.sum << " " << scanPoint.created.sum2
+				<< " " << scanPoint.detected.sum << " " << scanPoint.detected.sum2 << " " << scanPoint.tank[TankSD::kAlpha]
+				<< " " << scanPoint.tank[TankSD::kBeta] << " " << scanPoint.tank[TankSD::kGamma] << std::endl;
+		}
+		return;
+	}
+
+	// a scan writes the line of each point, in the order of the points, as
+	// a series of runs would
+	if (fScanPoints.empty())
+	{
+		outputFile << std::fixed << std::setprecision(2) << createdPhotons << " " << detectedPhotons << " " << photonYieldPercentage << " " << fAlphaCount << " " << betaCount << " " << gammaCount << std::endl;
+	}
+	for (const auto& scanPoint : fScanPoints)
+	{
+		const G4double created = scanPoint.events > 0 ? scanPoint.created.sum / scanPoint.events : 0.;
+		const G4double yield = created > 0. ? scanPoint.detected.sum / created * 100 : 0.;
+		outputFile << std::fixed << std::setprecision(2) << created << " " << scanPoint.detected.sum << " " << yield
+			<< " " << scanPoint.tank[TankSD::kAlpha] << " " << scanPoint.tank[TankSD::kBeta] << " " << scanPoint.tank[TankSD::kGamma] << std::endl;
+	}
 	outputFile.close();
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void Run::PrintScan() const
+{
+	G4cout << "Scan points (created photons per event, detected photons, yield):" << G4endl;
+	for (std::size_t i = 0; i < fScanPoints.size(); ++i)
+	{
+		const ScanPointTally& scanPoint = fScanPoints[i];
+		const G4double created = scanPoint.events > 0 ? scanPoint.created.sum / scanPoint.events : 0.;
+		const G4double yield = created > 0. ? scanPoint.detected.sum / created * 100 : 0.;
+		G4cout << "  " << i << ": " << G4BestUnit(fParameters.scanOrigins[i], "Length")
+			<< ", " << scanPoint.events << " events, " << created << " +- "
+			<< (scanPoint.events > 0 ? scanPoint.created.GetError(scanPoint.events) / scanPoint.events : 0.)
+			<< ", " << scanPoint.detected.sum << " +- " << scanPoint.detected.GetError(scanPoint.events)
+			<< ", " << yield << " %" << G4endl;
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void Run::PrintRayTrace() const
+{
+	// Geant4 per created photon, the ray tracer per traced photon; the
+	// first-surface statistics need /opnovice2/stepping/boundaryStats
+	const G4double created = fTallies[kScintillation].sum + fTallies[kCerenkov].sum;
+	const G4double traced = fRayTrace.photons;
+	const auto precision = G4cout.precision(4);
+	auto row = [&](const G4String& name, G4double geant4, G4double tracer) {
+		G4cout << "  " << std::left << std::setw(36) << name << std::right
+			<< std::setw(12) << (created > 0. ? geant4 / created : 0.)
+			<< std::setw(12) << tracer / traced << G4endl;
+	};
+
+	G4cout << "Ray tracer validation (" << static_cast<G4long>(traced)
+		<< " scintillation photons):" << G4endl;
+	G4cout << "  " << std::left << std::setw(36) << "per photon" << std::right
+		<< std::setw(12) << "Geant4" << std::setw(12) << "ray tracer" << G4endl;
+	row("detected", fTallies[kDetected].sum, fRayTrace.detected);
+	row("bulk absorption", fTallies[kOpAbsorption].sum, fRayTrace.absorbed);
+	row("bulk absorption before a surface", fTallies[kOpAbsorptionPrior].sum,
+		fRayTrace.absorbedPrior);
+	row("Rayleigh scatterings", fTallies[kRayleigh].sum, fRayTrace.rayleigh);
+
+	const std::pair<G4OpBoundaryProcessStatus, const char*> statuses[] = {
+		{ FresnelRefraction, "first surface: FresnelRefraction" },
+		{ FresnelReflection, "first surface: FresnelReflection" },
+		{ TotalInternalReflection, "first surface: TotalInternalRefl." },
+		{ SpikeReflection, "first surface: SpikeReflection" },
+		{ Absorption, "first surface: Absorption" },
+		{ NoRINDEX, "first surface: NoRINDEX" }
+	};
+	for (const auto& status : statuses)
+	{
+		row(status.second, fBoundaryProcs[status.first].sum,
+			fRayTrace.firstStatus[status.first]);
+	}
+	G4cout << "  ray tracer only: surface absorption " << fRayTrace.surface / traced
+		<< ", escaped " << fRayTrace.escaped / traced
+		<< ", step limit " << fRayTrace.lost / traced << G4endl;
+	G4cout.precision(precision);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 void Run::SetOutputFileName(const std::string& filename)
 {
 	if (filename.find(".txt") == std::string::npos) {
@@ -33,9 +33,13 @@
 #include "RunAction.hh"
 #include "Run.hh"
 #include "G4RunManager.hh"
+#include "G4TaskRunManager.hh"
 #include "HistoManager.hh"
 #include "PrimaryGeneratorAction.hh"
+#include "RunParameters.hh"
+#include "RunParametersMessenger.hh"
 #include "SteppingAction.hh"
+#include "StepContext.hh"
 #include "TrackingAction.hh"
 #include "G4AnalysisManager.hh"
 #include <fstream>
@@ -45,32 +49,43 @@
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 // }X^[pRXgN^
-RunAction::RunAction(const G4String& outputFileName)
+RunAction::RunAction(DetectorConstruction* detector, const G4String& outputFileName)
 	: G4UserRunAction(),
 	fRun(nullptr),
 	fHistoManager(nullptr),
 	fPrimary(nullptr),
 	fSteppingAction(nullptr),
+	fDetector(detector),
 	fOutputFileName(outputFileName)
 {
 	fHistoManager = new HistoManager();
+	fParametersMessenger = new RunParametersMessenger();
 }
 
 // [J[pRXgN^
-RunAction::RunAction(PrimaryGeneratorAction* prim, SteppingAction* stepping, const G4String& outputFileName)
+RunAction::RunAction(PrimaryGeneratorAction* prim, SteppingAction* stepping,
+	StepContext* context, const G4String& outputFileName)
 	: G4UserRunAction(),
 	fRun(nullptr),
 	fHistoManager(nullptr),
 	fPrimary(prim),
 	fSteppingAction(stepping),
+	fStepContext(context),
+	fDetector(context ? context->GetDetector() : nullptr),
 	fOutputFileName(outputFileName)
 {
 	fHistoManager = new HistoManager();
+	// a sequential run manager has no master RunAction (BuildForMaster is
+	// not called)
+	if (G4RunManager::GetRunManager()->GetRunManagerType() == G4RunManager::sequentialRM)
+		fParametersMessenger = new RunParametersMessenger();
 }
 
 RunAction::~RunAction()
 {
 	delete fHistoManager;
+	delete fStepContext;
+	delete fParametersMessenger;
 }
 
 
@@ -83,8 +98,53 @@ G4Run* RunAction::GenerateRun()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::BeginOfRunAction(const G4Run*)
+void RunAction::BeginOfRunAction(const G4Run* run)
 {
+	// the run manager chosen in main(), see OpNovice2.cc
+	if (isMaster)
+	{
+		const G4RunManager* runManager = G4RunManager::GetRunManager();
+		const char* type = "sequential";
+		if (dynamic_cast<const G4TaskRunManager*>(runManager))
+			type = "tasking";
+		else if (runManager->GetRunManagerType() == G4RunManager::masterRM)
+			type = "MT";
+		G4cout << "### Run " << run->GetRunID() << ": " << type << " run manager, "
+			<< runManager->GetNumberOfThreads() << " thread(s)" << G4endl;
+	}
+
+	// /opnovice2/scintFraction: the materials are shared, so only the
+	// master (or the sequential run manager) rescales them, before any
+	// worker starts its events; the uniform tables follow the MPTs
+	if (isMaster && fDetector)
+	{
+		fDetector->ApplyScintFractions();
+		fDetector->BuildOpticalTables();
+	}
+
+	// one copy of the source parameters per thread and run, so that the
+	// events read them without locking
+	const RunParameters params = RunParameters::GetPublished();
+	if (fRun)
+	{
+		fRun->SetParameters(params);
+	}
+	if (fPrimary)
+	{
+		fPrimary->SetRunParameters(params);
+	}
+
+	// per-thread cache read by the stepping and stacking actions
+	if (fStepContext)
+	{
+		fStepContext->BeginOfRun(fRun);
+	}
+
+	if (fSteppingAction)
+	{
+		fSteppingAction->BeginOfRun();
+	}
+
 	if (fPrimary)
 	{
 		G4ParticleDefinition* particle = fPrimary->GetParticleGun()->GetParticleDefinition();
@@ -92,6 +152,30 @@ void RunAction::BeginOfRunAction(const G4Run*)
 		G4bool polarized = fPrimary->GetPolarized();
 		G4double polarization = fPrimary->GetPolarization();
 		fRun->SetPrimary(particle, energy, polarized, polarization);
+
+		// /opnovice2/gun/biasCone: aim at the Tank of the current geometry;
+		// StackingAction biases the decay products through the context
+		DirectionBias& bias = fPrimary->GetDirectionBias();
+		if (bias.GetFraction() > 0. && fStepContext)
+		{
+			bias.SetTarget(fStepContext->GetTankVolume());
+			fStepContext->SetDirectionBias(bias.IsEnabled() ? &bias : nullptr);
+		}
+
+		// /opnovice2/lightmap/: the grid follows the current geometry; a map
+		// run fills it, the fast mode reads the stored one
+		if ((fPrimary->GetLightMapMode() || fPrimary->GetLightMapFast()) && fStepContext)
+		{
+			fPrimary->BuildLightMap(fStepContext->GetDetector(), fStepContext->GetWorldVolume());
+			if (fPrimary->GetLightMapMode())
+			{
+				fRun->SetLightMap(fPrimary->GetLightMap());
+			}
+			else if (fPrimary->LoadLightMap())
+			{
+				fStepContext->SetLightMap(&fPrimary->GetLightMap());
+			}
+		}
 	}
 
 	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
@@ -110,13 +194,6 @@ void RunAction::BeginOfRunAction(const G4Run*)
 
 void RunAction::EndOfRunAction(const G4Run*)
 {
-	if (fSteppingAction)
-	{
-		G4int gammaCount = fSteppingAction->GetGammaCount();
-		G4cout << "Gamma Count in Detector: " << gammaCount << G4endl;
-		fSteppingAction->ResetGammaCount();
-	}
-
 	if (isMaster && fRun)
 	{
 		fRun->EndOfRun();
@@ -311,6 +388,14 @@ void RunAction::EndOfRunAction(const G4Run*)
 		analysisManager->Write();
 		analysisManager->CloseFile();
 	}
+	if (fSteppingAction)
+	{
+		fSteppingAction->EndOfRun();
+	}
+	if (fStepContext)
+	{
+		fStepContext->EndOfRun();
+	}
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
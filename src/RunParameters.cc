@@ -0,0 +1,78 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/src/RunParameters.cc
+/// \brief Implementation of the RunParameters class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "RunParameters.hh"
+
+#include "G4AutoLock.hh"
+#include "G4UnitsTable.hh"
+
+namespace
+{
+G4Mutex publishedMutex = G4MUTEX_INITIALIZER;
+RunParameters published;
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunParameters::Publish(const RunParameters& params)
+{
+  G4AutoLock lock(&publishedMutex);
+  published = params;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunParameters RunParameters::GetPublished()
+{
+  G4AutoLock lock(&publishedMutex);
+  return published;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunParameters::Print() const
+{
+  G4cout << "source origin: " << G4BestUnit(sourceOrigin, "Length") << ", energy: ";
+  if(sourceEnergy < 0.)
+    G4cout << "default";
+  else
+    G4cout << G4BestUnit(sourceEnergy, "Energy");
+  G4cout << ", direction: "
+         << (sourceDirection == SourceDirection::Beam ? "beam" : "isotropic")
+         << G4endl;
+  if(!scanOrigins.empty())
+  {
+    G4cout << "scan: " << scanOrigins.size() << " points of " << eventsPerPoint
+           << " events" << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,152 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file optical/OpNovice2/src/RunParametersMessenger.cc
+/// \brief Implementation of the RunParametersMessenger class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "RunParametersMessenger.hh"
+#include "RunParameters.hh"
+
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIdirectory.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunParametersMessenger::RunParametersMessenger()
+  : G4UImessenger()
+{
+  fRunDir = new G4UIdirectory("/opnovice2/run/", false);
+  fRunDir->SetGuidance("Source parameters of the next runs");
+
+  fOriginCmd =
+    new G4UIcmdWith3VectorAndUnit("/opnovice2/run/sourceOrigin", this);
+  fOriginCmd->SetGuidance("Centre of the source (default 10 0 0 mm).");
+  fOriginCmd->SetParameterName("x", "y", "z", false);
+  fOriginCmd->SetDefaultUnit("mm");
+  fOriginCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fOriginCmd->SetToBeBroadcasted(false);
+
+  fEnergyCmd =
+    new G4UIcmdWithADoubleAndUnit("/opnovice2/run/sourceEnergy", this);
+  fEnergyCmd->SetGuidance("Kinetic energy of the primary particle.");
+  fEnergyCmd->SetGuidance(
+    "A negative value keeps the energy of the selected source (default).");
+  fEnergyCmd->SetParameterName("energy", false);
+  fEnergyCmd->SetDefaultUnit("MeV");
+  fEnergyCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEnergyCmd->SetToBeBroadcasted(false);
+
+  fDirectionCmd =
+    new G4UIcmdWithAString("/opnovice2/run/sourceDirection", this);
+  fDirectionCmd->SetGuidance("Direction of the primary particle.");
+  fDirectionCmd->SetGuidance(
+    "  isotropic : over 4 pi, see also /opnovice2/gun/biasCone (default)");
+  fDirectionCmd->SetGuidance("  beam      : along -z");
+  fDirectionCmd->SetParameterName("direction", false);
+  fDirectionCmd->SetCandidates("isotropic beam");
+  fDirectionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fDirectionCmd->SetToBeBroadcasted(false);
+
+  fScanPointCmd =
+    new G4UIcmdWith3VectorAndUnit("/opnovice2/run/scanPoint", this);
+  fScanPointCmd->SetGuidance("Add a source origin to the scan.");
+  fScanPointCmd->SetGuidance(
+    "The points are run in one BeamOn of N x eventsPerPoint events and");
+  fScanPointCmd->SetGuidance("the results are written one line per point.");
+  fScanPointCmd->SetParameterName("x", "y", "z", false);
+  fScanPointCmd->SetDefaultUnit("mm");
+  fScanPointCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fScanPointCmd->SetToBeBroadcasted(false);
+
+  fEventsPerPointCmd =
+    new G4UIcmdWithAnInteger("/opnovice2/run/eventsPerPoint", this);
+  fEventsPerPointCmd->SetGuidance("Number of events of each scan point.");
+  fEventsPerPointCmd->SetParameterName("N", false);
+  fEventsPerPointCmd->SetRange("N > 0");
+  fEventsPerPointCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEventsPerPointCmd->SetToBeBroadcasted(false);
+
+  fScanClearCmd =
+    new G4UIcmdWithoutParameter("/opnovice2/run/scanClear", this);
+  fScanClearCmd->SetGuidance("Remove all the scan points.");
+  fScanClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fScanClearCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunParametersMessenger::~RunParametersMessenger()
+{
+  delete fOriginCmd;
+  delete fEnergyCmd;
+  delete fDirectionCmd;
+  delete fScanPointCmd;
+  delete fEventsPerPointCmd;
+  delete fScanClearCmd;
+  delete fRunDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunParametersMessenger::SetNewValue(G4UIcommand* command,
+                                         G4String newValue)
+{
+  RunParameters params = RunParameters::GetPublished();
+  if(command == fOriginCmd)
+  {
+    params.sourceOrigin = fOriginCmd->GetNew3VectorValue(newValue);
+  }
+  else if(command == fEnergyCmd)
+  {
+    params.sourceEnergy = fEnergyCmd->GetNewDoubleValue(newValue);
+  }
+  else if(command == fDirectionCmd)
+  {
+    params.sourceDirection = newValue == "beam" ? SourceDirection::Beam
+                                                : SourceDirection::Isotropic;
+  }
+  else if(command == fScanPointCmd)
+  {
+    params.scanOrigins.push_back(fScanPointCmd->GetNew3VectorValue(newValue));
+  }
+  else if(command == fEventsPerPointCmd)
+  {
+    params.eventsPerPoint = fEventsPerPointCmd->GetNewIntValue(newValue);
+  }
+  else if(command == fScanClearCmd)
+  {
+    params.scanOrigins.clear();
+  }
+  RunParameters::Publish(params);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,303 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/src/StackingAction.cc
+/// \brief Implementation of the StackingAction class
+//
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "StackingAction.hh"
+
+#include "DetectorConstruction.hh"
+#include "DirectionBias.hh"
+#include "HistoManager.hh"
+#include "LightMap.hh"
+#include "OpticalTables.hh"
+#include "Run.hh"
+#include "StackingMessenger.hh"
+#include "StepContext.hh"
+#include "TrackInformation.hh"
+
+#include "G4HadronicProcessType.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "Randomize.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingAction::StackingAction(StepContext* context)
+  : G4UserStackingAction(), fContext(context)
+{
+  fStackingMessenger = new StackingMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingAction::~StackingAction()
+{
+  delete fStackingMessenger;
+  delete fQE;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::SetQuantumEfficiency(G4MaterialPropertyVector* qe)
+{
+  delete fQE;
+  fQE = qe;
+  fQEPeak = (fQE && fQE->GetVectorLength() > 0) ? fQE->GetMaxValue() : 0.;
+  // looked at again by the next photon
+  fQERunID = -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(
+  const G4Track* track)
+{
+  if(track->GetParticleDefinition() != fContext->GetOpticalPhoton())
+  {
+    BiasDecayProduct(track);
+    return fUrgent;
+  }
+
+  const G4VProcess* creator = track->GetCreatorProcess();
+  Run* run = fContext->GetRun();
+  if(creator && run)
+  {
+    // the weight of the parent, set in TrackingAction
+    auto info = static_cast<TrackInformation*>(track->GetUserInformation());
+    G4double weight = info ? info->GetWeight() : 1.;
+
+    G4AnalysisManager* analysisMan = fContext->GetAnalysisManager();
+    if(creator == fContext->GetScintProcess())
+    {
+      // /opnovice2/scintFraction: the material generated only a fraction of
+      // its photons, each stands for 1/f of them
+      const G4VPhysicalVolume* volume = track->GetVolume();
+      const G4double scale = volume ? fContext->GetDetector()->GetScintWeight(
+                                        volume->GetLogicalVolume()->GetMaterial())
+                                    : 1.;
+      if(scale != 1. && info)
+      {
+        weight *= scale;
+        info->SetWeight(weight);
+      }
+
+      G4double en = track->GetKineticEnergy();
+      run->AddScintillationEnergy(en, weight);
+      run->AddScintillation(weight);
+      analysisMan->FillH1(2, en / eV, weight);
+      analysisMan->FillH1(3, track->GetGlobalTime() / ns, weight);
+
+      if(fRayTraceSamples > 0)
+      {
+        SampleForRayTrace(track, run);
+      }
+
+      if(IsOutOfGate(track->GetGlobalTime(), weight, run) ||
+         (fQE && !AcceptSpectrum(track, info, weight, run)))
+      {
+        return fKill;
+      }
+
+      // fast mode: detected with the collection efficiency of the
+      // emission point instead of being tracked; photons outside the map
+      // are tracked as usual
+      const LightMap* map = fContext->GetLightMap();
+      const G4int cell = map ? map->FindCell(track->GetPosition()) : -1;
+      if(cell >= 0)
+      {
+        if(G4UniformRand() < map->GetEfficiency(cell))
+        {
+          const G4double arrival =
+            track->GetGlobalTime() + map->SampleArrivalTime(cell);
+          if(!IsOutOfGate(arrival, weight, run))
+          {
+            run->AddPhotonArrival(arrival, weight);
+          }
+        }
+        return fKill;
+      }
+    }
+    else if(creator == fContext->GetCerenkovProcess())
+    {
+      G4double en = track->GetKineticEnergy();
+      run->AddCerenkovEnergy(en, weight);
+      run->AddCerenkov(weight);
+      analysisMan->FillH1(1, en / eV, weight);
+
+      if(IsOutOfGate(track->GetGlobalTime(), weight, run) ||
+         (fQE && !AcceptSpectrum(track, info, weight, run)))
+      {
+        return fKill;
+      }
+    }
+  }
+
+  // primary photons from the gun and weight window copies are always
+  // tracked; killing or deferring a copy would lose or delay part of the
+  // weight of a photon already being tracked
+  auto info = static_cast<TrackInformation*>(track->GetUserInformation());
+  if(track->GetParentID() == 0 || (info && info->IsSplitCopy()))
+  {
+    return fUrgent;
+  }
+
+  switch(fPhotonPolicy)
+  {
+    case PhotonStackPolicy::Kill:
+      return fKill;
+    case PhotonStackPolicy::Defer:
+      return fWaiting;
+    default:
+      break;
+  }
+  return fUrgent;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::BiasDecayProduct(const G4Track* track) const
+{
+  const DirectionBias* bias = fContext->GetDirectionBias();
+  const G4VProcess* creator = track->GetCreatorProcess();
+  if(!bias || !creator || creator->GetProcessType() != fDecay ||
+     creator->GetProcessSubType() != fRadioactiveDecay)
+  {
+    return;
+  }
+  // the recoiling nucleus decays in turn; neutrinos never reach anything
+  const G4ParticleDefinition* particle = track->GetParticleDefinition();
+  if(particle->IsGeneralIon() ||
+     (particle->GetLeptonNumber() != 0 && particle->GetPDGCharge() == 0.))
+  {
+    return;
+  }
+  auto info = static_cast<TrackInformation*>(track->GetUserInformation());
+  if(!info) return;
+
+  // not tracked yet: the direction can still be changed in place
+  G4ThreeVector direction;
+  const G4double weight = bias->Sample(track->GetPosition(), direction);
+  const_cast<G4Track*>(track)->SetMomentumDirection(direction);
+  info->SetWeight(info->GetWeight() * weight);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StackingAction::IsOutOfGate(G4double time, G4double weight,
+                                   Run* run) const
+{
+  const G4double gate = fContext->GetTimeGate();
+  if(gate <= 0. || time <= gate) return false;
+  run->AddOutOfGate(weight);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool StackingAction::AcceptSpectrum(const G4Track* track,
+                                      TrackInformation* info,
+                                      G4double& weight, Run* run)
+{
+  if(run->GetRunID() != fQERunID)
+  {
+    fQERunID = run->GetRunID();
+    // a wavelength shifter can move a photon from outside the band into it
+    const OpticalTables& tables = fContext->GetDetector()->GetOpticalTables();
+    fQEActive = fQEPeak > 0. && !tables.Has(OpticalTables::kWLSAbsLength) &&
+                !tables.Has(OpticalTables::kWLSAbsLength2);
+    if(!fQEActive && G4Threading::G4GetThreadId() <= 0)
+    {
+      G4ExceptionDescription ed;
+      ed << "The quantum efficiency curve is ignored in this run: "
+         << (fQEPeak > 0. ? "a material has a wavelength shifter."
+                          : "it is zero everywhere.");
+      G4Exception("StackingAction::AcceptSpectrum", "OpNovice2_009",
+                  JustWarning, ed);
+    }
+  }
+  if(!fQEActive) return true;
+
+  // outside the band: never seen by the readout
+  const G4double en = track->GetKineticEnergy();
+  const G4double qe = (en < fQE->GetMinEnergy() || en > fQE->GetMaxEnergy())
+                        ? 0.
+                        : fQE->Value(en);
+  if(qe <= 0.)
+  {
+    run->AddSpectralCut(Run::kOutOfBand);
+    return false;
+  }
+
+  // in the band: kept with probability QE/peak, each survivor then
+  // stands for peak/QE photons of which a fraction QE is converted, so
+  // the detected tallies become photoelectrons
+  if(G4UniformRand() * fQEPeak >= qe)
+  {
+    run->AddSpectralCut(Run::kRouletted);
+    return false;
+  }
+  weight *= fQEPeak;
+  if(info) info->SetWeight(weight);
+  run->AddSpectralCut(Run::kAccepted);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::SampleForRayTrace(const G4Track* track, Run* run)
+{
+  if(run->GetRunID() != fRayTraceRunID)
+  {
+    fRayTraceRunID = run->GetRunID();
+    fRayTraced = 0;
+    fPhotonBatch.Clear();
+    if(fOpticalStack.Build(fContext->GetDetector(), fContext->GetWorldVolume()) &&
+       G4Threading::G4GetThreadId() <= 0)
+    {
+      fOpticalStack.Print();
+    }
+  }
+  if(!fOpticalStack.IsBuilt() || fRayTraced >= fRayTraceSamples) return;
+
+  if(fOpticalStack.Add(fPhotonBatch, track->GetPosition(),
+                       track->GetMomentumDirection(), track->GetKineticEnergy()))
+  {
+    // traced a batch at a time; the last one when the sample is complete
+    ++fRayTraced;
+    if(fPhotonBatch.IsFull() || fRayTraced == fRayTraceSamples)
+    {
+      fOpticalStack.Trace(fPhotonBatch, run->GetRayTrace());
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
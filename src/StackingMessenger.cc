@@ -0,0 +1,140 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/src/StackingMessenger.cc
+/// \brief Implementation of the StackingMessenger class
+//
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "StackingMessenger.hh"
+#include "StackingAction.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4MaterialPropertyVector.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingMessenger::StackingMessenger(StackingAction* stackingAction)
+  : G4UImessenger(),
+    fStackingAction(stackingAction)
+{
+  fStackingDir = new G4UIdirectory("/opnovice2/stacking/");
+  fStackingDir->SetGuidance("Stacking control");
+
+  fPhotonPolicyCmd =
+    new G4UIcmdWithAString("/opnovice2/stacking/opticalPhotons", this);
+  fPhotonPolicyCmd->SetGuidance(
+    "What to do with secondary optical photons once they are counted.");
+  fPhotonPolicyCmd->SetGuidance("  track : track them (default)");
+  fPhotonPolicyCmd->SetGuidance(
+    "  kill  : only count them (created-photon statistics)");
+  fPhotonPolicyCmd->SetGuidance(
+    "  defer : track them after the rest of the event");
+  fPhotonPolicyCmd->SetParameterName("policy", false);
+  fPhotonPolicyCmd->SetCandidates("track kill defer");
+  fPhotonPolicyCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fRayTraceCmd =
+    new G4UIcmdWithAnInteger("/opnovice2/stacking/rayTraceValidate", this);
+  fRayTraceCmd->SetGuidance(
+    "Also trace the first N scintillation photons of each thread with the");
+  fRayTraceCmd->SetGuidance(
+    "standalone ray tracer (OpticalStack) and print its detected fraction");
+  fRayTraceCmd->SetGuidance(
+    "and first-surface statistics next to those of Geant4 at the end of");
+  fRayTraceCmd->SetGuidance("the run. 0 disables it (default).");
+  fRayTraceCmd->SetParameterName("N", false);
+  fRayTraceCmd->SetRange("N >= 0");
+  fRayTraceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fQECmd = new G4UIcmdWithAString("/opnovice2/stacking/qe", this);
+  fQECmd->SetGuidance(
+    "Quantum efficiency curve of the Tank readout: pairs of photon energy");
+  fQECmd->SetGuidance(
+    "(internal units, as /opnovice2/boxProperty) and efficiency.");
+  fQECmd->SetGuidance(
+    "Created photons outside the band are killed when stacked, the others");
+  fQECmd->SetGuidance(
+    "are kept with probability QE/peak QE and weighted by the peak QE, so");
+  fQECmd->SetGuidance("that the detected photons become photoelectrons.");
+  fQECmd->SetGuidance("none removes the curve (default).");
+  fQECmd->SetParameterName("curve", false);
+  fQECmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingMessenger::~StackingMessenger()
+{
+  delete fStackingDir;
+  delete fPhotonPolicyCmd;
+  delete fRayTraceCmd;
+  delete fQECmd;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingMessenger::SetNewValue(G4UIcommand* command,
+                                    G4String newValue)
+{
+  if(command == fPhotonPolicyCmd)
+  {
+    PhotonStackPolicy policy = PhotonStackPolicy::Track;
+    if(newValue == "kill")
+      policy = PhotonStackPolicy::Kill;
+    else if(newValue == "defer")
+      policy = PhotonStackPolicy::Defer;
+    fStackingAction->SetPhotonPolicy(policy);
+  }
+  else if(command == fRayTraceCmd)
+  {
+    fStackingAction->SetRayTraceSamples(
+      G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+  }
+  else if(command == fQECmd)
+  {
+    if(newValue == "none")
+    {
+      fStackingAction->SetQuantumEfficiency(nullptr);
+      return;
+    }
+    // space delimited pairs of energy, value
+    auto qe = new G4MaterialPropertyVector();
+    std::istringstream instring(newValue);
+    G4double en, val;
+    while(instring >> en >> val)
+    {
+      qe->InsertValues(en, val);
+    }
+    fStackingAction->SetQuantumEfficiency(qe);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,289 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/src/StepBenchmark.cc
+/// \brief Implementation of the StepBenchmark class
+//
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "StepBenchmark.hh"
+
+#include "DetectorConstruction.hh"
+#include "HistoManager.hh"
+#include "Run.hh"
+#include "SteppingAction.hh"
+
+#include "G4Alpha.hh"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4OpProcessSubType.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Positron.hh"
+#include "G4SDManager.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4VSensitiveDetector.hh"
+
+#include <chrono>
+#include <iomanip>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepBenchmark::StepBenchmark(SteppingAction* stepping,
+                             DetectorConstruction* detector)
+  : fSteppingAction(stepping),
+    fDetector(detector)
+{
+  fOpticalPhoton = G4OpticalPhoton::OpticalPhotonDefinition();
+  fAlpha = G4Alpha::Definition();
+  fElectron = G4Electron::Definition();
+  fPositron = G4Positron::Definition();
+  fGamma = G4Gamma::Definition();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepBenchmark::~StepBenchmark()
+{
+  Clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* StepBenchmark::GetBranchName(G4int branch)
+{
+  static const char* names[kNBranches] = {
+    "optical boundary", "optical WLS", "optical bulk",
+    "charged + secondaries", "Tank entry (SD)"
+  };
+  return names[branch];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int StepBenchmark::Classify(const G4Step* step) const
+{
+  const G4ParticleDefinition* particle =
+    step->GetTrack()->GetParticleDefinition();
+  const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+  const G4StepPoint* postStepPoint = step->GetPostStepPoint();
+
+  if(particle == fOpticalPhoton)
+  {
+    if(postStepPoint->GetStepStatus() == fGeomBoundary)
+      return kOpticalBoundary;
+    const G4VProcess* pds = postStepPoint->GetProcessDefinedStep();
+    G4int type = pds ? pds->GetProcessSubType() : -1;
+    return (type == fOpWLS || type == fOpWLS2) ? kOpticalWLS : kOpticalBulk;
+  }
+
+  if((particle == fAlpha || particle == fElectron || particle == fPositron ||
+      particle == fGamma) &&
+     preStepPoint->GetStepStatus() == fGeomBoundary &&
+     fDetector->GetVolumeRole(preStepPoint->GetPhysicalVolume()) ==
+       VolumeRole::Tank)
+  {
+    return kTankEntry;
+  }
+
+  if(particle->GetPDGCharge() != 0. &&
+     !step->GetSecondaryInCurrentStep()->empty())
+  {
+    return kChargedSecondaries;
+  }
+  return -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepBenchmark::Record(const G4Step* step)
+{
+  G4int branch = Classify(step);
+  if(branch < 0 ||
+     fSteps[branch].size() >= static_cast<std::size_t>(fMaxSteps))
+  {
+    return;
+  }
+
+  const G4Track* track = step->GetTrack();
+
+  RecordedStep rec;
+  rec.track = new G4Track(*track);
+  rec.step = new G4Step();
+  *rec.step->GetPreStepPoint() = *step->GetPreStepPoint();
+  *rec.step->GetPostStepPoint() = *step->GetPostStepPoint();
+  rec.step->SetStepLength(step->GetStepLength());
+  rec.step->SetTotalEnergyDeposit(step->GetTotalEnergyDeposit());
+  rec.step->SetTrack(rec.track);
+  rec.track->SetStep(rec.step);
+
+  // the G4Step owns the vector, we own the secondary tracks
+  auto secondaries = new G4TrackVector;
+  for(auto sec : *step->GetSecondaryInCurrentStep())
+  {
+    rec.secondaries.push_back(new G4Track(*sec));
+    secondaries->push_back(rec.secondaries.back());
+  }
+  rec.step->SetSecondary(secondaries);
+
+  auto info = static_cast<TrackInformation*>(track->GetUserInformation());
+  if(info)
+  {
+    rec.info = *info;
+    rec.reflectionNumber = info->GetReflectionNumber();
+  }
+  rec.track->SetUserInformation(new TrackInformation(&rec.info));
+  rec.status = track->GetTrackStatus();
+  rec.boundaryStatus = fSteppingAction->GetBoundaryStatus();
+
+  fSteps[branch].push_back(std::move(rec));
+
+  fFull = true;
+  for(const auto& steps : fSteps)
+  {
+    if(steps.size() < static_cast<std::size_t>(fMaxSteps))
+    {
+      fFull = false;
+      break;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepBenchmark::Restore(RecordedStep& rec) const
+{
+  auto info = static_cast<TrackInformation*>(rec.track->GetUserInformation());
+  *info = rec.info;
+  info->SetReflectionNumber(rec.reflectionNumber);
+  rec.track->SetTrackStatus(rec.status);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepBenchmark::Replay()
+{
+  if(fMaxSteps <= 0)
+  {
+    return;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  auto elapsedNs = [](Clock::time_point start) {
+    return std::chrono::duration<G4double, std::nano>(Clock::now() - start)
+      .count();
+  };
+
+  // counters and histograms filled by the replay go to a scratch run; the
+  // histograms of this thread are reset afterwards (the run output has
+  // already been written)
+  Run scratchRun;
+
+  G4VSensitiveDetector* tankSD =
+    G4SDManager::GetSDMpointer()->FindSensitiveDetector("TankSD", false);
+  G4HCofThisEvent hce(G4SDManager::GetSDMpointer()->GetCollectionCapacity());
+  if(tankSD)
+  {
+    tankSD->Initialize(&hce);
+  }
+
+  G4cout << G4endl << "----- Stepping benchmark: " << fRepetitions
+         << " replays -----" << G4endl;
+  for(G4int branch = 0; branch < kNBranches; ++branch)
+  {
+    auto& steps = fSteps[branch];
+    if(steps.empty() || (branch == kTankEntry && !tankSD))
+    {
+      continue;
+    }
+
+    // cost of restoring the modified track state, subtracted below
+    auto start = Clock::now();
+    for(G4int i = 0; i < fRepetitions; ++i)
+    {
+      for(auto& rec : steps)
+      {
+        Restore(rec);
+      }
+    }
+    G4double restoreNs = elapsedNs(start);
+
+    start = Clock::now();
+    for(G4int i = 0; i < fRepetitions; ++i)
+    {
+      for(auto& rec : steps)
+      {
+        Restore(rec);
+        if(branch == kTankEntry)
+        {
+          tankSD->Hit(rec.step);
+        }
+        else
+        {
+          fSteppingAction->SetReplayBoundaryStatus(&rec.boundaryStatus);
+          fSteppingAction->ProcessStep(rec.step, &scratchRun);
+        }
+      }
+    }
+    G4double totalNs = elapsedNs(start);
+    fSteppingAction->SetReplayBoundaryStatus(nullptr);
+
+    G4double nCalls = static_cast<G4double>(fRepetitions) * steps.size();
+    G4cout << std::setw(24) << std::left << GetBranchName(branch)
+           << std::right << std::setw(7) << steps.size() << " steps "
+           << std::fixed << std::setprecision(1) << std::setw(9)
+           << (totalNs - restoreNs) / nCalls << " ns/step" << G4endl;
+  }
+  G4cout << "-------------------------------------------------" << G4endl;
+
+  G4AnalysisManager::Instance()->Reset();
+  Clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepBenchmark::Clear()
+{
+  for(auto& steps : fSteps)
+  {
+    for(auto& rec : steps)
+    {
+      for(auto sec : rec.secondaries)
+      {
+        delete sec;
+      }
+      delete rec.step;
+      delete rec.track;
+    }
+    steps.clear();
+  }
+  fFull = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,117 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/src/StepContext.cc
+/// \brief Implementation of the StepContext class
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "StepContext.hh"
+
+#include "DetectorConstruction.hh"
+#include "Run.hh"
+
+#include "G4Alpha.hh"
+#include "G4Cerenkov.hh"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4Navigator.hh"
+#include "G4OpBoundaryProcess.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4ProcessTable.hh"
+#include "G4Scintillation.hh"
+#include "G4TransportationManager.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepContext::StepContext(DetectorConstruction* detector)
+  : fDetector(detector)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepContext::BeginOfRun(Run* run)
+{
+  fRun = run;
+
+  // histograms are booked and (de)activated before the run starts
+  fAnalysisManager = G4AnalysisManager::Instance();
+  const G4int nH1 = fAnalysisManager->GetNofH1s();
+  const G4bool all = !fAnalysisManager->GetActivation();
+  fH1Active.assign(nH1, false);
+  for(G4int id = 0; id < nH1; ++id)
+  {
+    fH1Active[id] = all || fAnalysisManager->GetH1Activation(id);
+  }
+
+  fOpticalPhoton = G4OpticalPhoton::OpticalPhotonDefinition();
+  fElectron = G4Electron::Definition();
+  fGamma = G4Gamma::Definition();
+  fAlpha = G4Alpha::Definition();
+
+  // The process objects are thread-local; G4OpticalPhysics attaches a
+  // single Scintillation/Cerenkov instance per thread to every applicable
+  // particle, so the electron entry is enough
+  G4ProcessTable* processTable = G4ProcessTable::GetProcessTable();
+  fAbsorptionProcess = processTable->FindProcess("OpAbsorption", fOpticalPhoton);
+  fRayleighProcess = processTable->FindProcess("OpRayleigh", fOpticalPhoton);
+  fWLSProcess = processTable->FindProcess("OpWLS", fOpticalPhoton);
+  fWLS2Process = processTable->FindProcess("OpWLS2", fOpticalPhoton);
+  fBoundaryProcess = dynamic_cast<G4OpBoundaryProcess*>(
+    processTable->FindProcess("OpBoundary", fOpticalPhoton));
+  fScintProcess = dynamic_cast<G4Scintillation*>(
+    processTable->FindProcess("Scintillation", fElectron));
+  fCerenkovProcess = dynamic_cast<G4Cerenkov*>(
+    processTable->FindProcess("Cerenkov", fElectron));
+
+  fWorldVolume = G4TransportationManager::GetTransportationManager()
+                   ->GetNavigatorForTracking()->GetWorldVolume();
+  fTankVolume = fDetector ? fDetector->GetTank() : nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepContext::EndOfRun()
+{
+  // the detector and particle definitions outlive the run; everything
+  // else may be rebuilt before the next BeamOn
+  fRun = nullptr;
+  fAnalysisManager = nullptr;
+  fH1Active.clear();
+  fAbsorptionProcess = nullptr;
+  fRayleighProcess = nullptr;
+  fWLSProcess = nullptr;
+  fWLS2Process = nullptr;
+  fBoundaryProcess = nullptr;
+  fScintProcess = nullptr;
+  fCerenkovProcess = nullptr;
+  fWorldVolume = nullptr;
+  fTankVolume = nullptr;
+  fLightMap = nullptr;
+  fDirectionBias = nullptr;
+  fTimeGate = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -33,551 +33,548 @@
 #include "DetectorConstruction.hh"
 #include "HistoManager.hh"
 #include "Run.hh"
+#include "StepBenchmark.hh"
+#include "StepContext.hh"
 #include "SteppingMessenger.hh"
 #include "TrackInformation.hh"
 
 #include "G4Cerenkov.hh"
+#include "G4DynamicParticle.hh"
 #include "G4Event.hh"
 #include "G4EventManager.hh"
+#include "G4LogicalVolumeStore.hh"
 #include "G4Scintillation.hh"
 #include "G4OpBoundaryProcess.hh"
+#include "G4OpProcessSubType.hh"
 #include "G4OpticalPhoton.hh"
 #include "G4ProcessManager.hh"
 #include "G4Step.hh"
 #include "G4SteppingManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4Track.hh"
-#include "G4RunManager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
-SteppingAction::SteppingAction(DetectorConstruction* detector)
-	: G4UserSteppingAction(), gammaCount(0), fDetector(detector)
+SteppingAction::SteppingAction(DetectorConstruction* detector, StepContext* context)
+	: G4UserSteppingAction(), fContext(context), fDetector(detector)
 {
 	fSteppingMessenger = new SteppingMessenger(this);
+	fBenchmark = new StepBenchmark(this, detector);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 SteppingAction::~SteppingAction()
 {
 	delete fSteppingMessenger;
+	delete fBenchmark;
 }
 
-///----------------------------------------------------------------------------------------
-// XebsOANV֐
-///----------------------------------------------------------------------------------------
-void SteppingAction::UserSteppingAction(const G4Step* step)
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void SteppingAction::BeginOfRun()
 {
-	static G4ParticleDefinition* opticalphoton =
-		G4OpticalPhoton::OpticalPhotonDefinition();
+	// copy the handles tested on every optical step; StepContext has
+	// resolved them for this thread in RunAction::BeginOfRunAction()
+	const G4ParticleDefinition* opticalphoton = fContext->GetOpticalPhoton();
+	fAbsorptionProcess = fContext->GetAbsorptionProcess();
+	fRayleighProcess = fContext->GetRayleighProcess();
+	fWLSProcess = fContext->GetWLSProcess();
+	fWLS2Process = fContext->GetWLS2Process();
+	fBoundaryProcess = fContext->GetBoundaryProcess();
+	fScintProcess = fContext->GetScintProcess();
+	fCerenkovProcess = fContext->GetCerenkovProcess();
+
+	// boundary status -> angle histograms (and the Fresnel-refraction
+	// direction histograms 17-19); see HistoManager::Book()
+	auto isActive = [this](G4int id) { return fContext->IsH1Active(id); };
+	auto setAngles = [this, &isActive](G4OpBoundaryProcessStatus status,
+		G4int id0, G4int id1) {
+		BoundaryHistos& histos = fBoundaryHistos[status];
+		G4int n = 0;
+		for (G4int id : { id0, id1 })
+		{
+			if (id >= 0 && isActive(id)) histos.angle[n++] = id;
+		}
+	};
+
+	fBoundaryHistos.fill(BoundaryHistos());
+	setAngles(Transmission, 25, -1);
+	setAngles(FresnelRefraction, 20, -1);
+	setAngles(FresnelReflection, 21, 23);
+	setAngles(TotalInternalReflection, 22, 23);
+	setAngles(SpikeReflection, 26, -1);
+	setAngles(Absorption, 24, -1);
+	fBoundaryHistos[FresnelRefraction].direction =
+		isActive(17) || isActive(18) || isActive(19);
+
+	// weight window importances, by logical volume instance ID
+	fImportance.clear();
+	if (fWeightWindow)
+	{
+		for (const auto& entry : fImportanceByName)
+		{
+			const G4LogicalVolume* lv =
+				G4LogicalVolumeStore::GetInstance()->GetVolume(entry.first, false);
+			if (!lv)
+			{
+				G4ExceptionDescription ed;
+				ed << "No logical volume " << entry.first << "; its importance is ignored.";
+				G4Exception("SteppingAction::BeginOfRun", "OpNovice2_007",
+					JustWarning, ed);
+				continue;
+			}
+			const auto id = static_cast<std::size_t>(lv->GetInstanceID());
+			if (id >= fImportance.size()) fImportance.resize(id + 1, 1.);
+			fImportance[id] = entry.second;
+		}
+	}
 
-	G4AnalysisManager* analysisMan = G4AnalysisManager::Instance();
-	Run* run =
-		static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+	// the gate of this run, also applied by StackingAction
+	fContext->SetTimeGate(fTimeGate);
 
-	G4Track* track = step->GetTrack();
-	G4StepPoint* endPoint = step->GetPostStepPoint();
-	G4StepPoint* startPoint = step->GetPreStepPoint();
+	// /opnovice2/roi/: the envelope follows the current geometry
+	fWorldVolume = fContext->GetWorldVolume();
+	fRoiActive = fRoi.IsEnabled() && fRoi.Build(fWorldVolume);
+	if (fRoiActive && fVerbose > 0) fRoi.Print();
 
-	const G4DynamicParticle* theParticle = track->GetDynamicParticle();
-	const G4ParticleDefinition* particleDef =
-		theParticle->GetParticleDefinition();
+	// stepping handlers; every other particle falls back to
+	// HandleDefault(). Tank entries of alpha/beta/gamma are scored by
+	// TankSD, see DetectorConstruction::ConstructSDandField().
+	fHandlers.clear();
+	RegisterHandler(opticalphoton, SelectOpticalHandler());
+}
 
-	auto trackInfo = (TrackInformation*)(track->GetUserInformation());
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void SteppingAction::EndOfRun()
+{
+	// replay the steps recorded during this run, if requested
+	fBenchmark->Replay();
+}
 
-	/////////////////////////////////////////////////////////////////////////////////////////
-	// oɓBƂJEg֐
-	/////////////////////////////////////////////////////////////////////////////////////////
-	static G4ParticleDefinition* alphaParticle =
-		G4ParticleTable::GetParticleTable()->FindParticle("alpha");
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+G4OpBoundaryProcessStatus SteppingAction::GetBoundaryStatus() const
+{
+	if (fReplayBoundaryStatus) return *fReplayBoundaryStatus;
+	return fBoundaryProcess ? fBoundaryProcess->GetStatus() : Undefined;
+}
 
-	if (particleDef == alphaParticle) // Ȃ
-	{
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+SteppingAction::StepHandler SteppingAction::SelectOpticalHandler() const
+{
+	// one instantiation per combination of the bookkeeping options, so the
+	// variant chosen for this run carries no checks for disabled features
+	static const StepHandler handlers[2][2][2] = {
+		{ { &SteppingAction::HandleOptical<false, false, false>,
+			&SteppingAction::HandleOptical<false, false, true> },
+		  { &SteppingAction::HandleOptical<false, true, false>,
+			&SteppingAction::HandleOptical<false, true, true> } },
+		{ { &SteppingAction::HandleOptical<true, false, false>,
+			&SteppingAction::HandleOptical<true, false, true> },
+		  { &SteppingAction::HandleOptical<true, true, false>,
+			&SteppingAction::HandleOptical<true, true, true> } }
+	};
+	return handlers[fBoundaryStats][fWLSStats][fHistograms];
+}
 
-		G4VPhysicalVolume* preVolume = step->GetPreStepPoint()->GetPhysicalVolume();
-		G4VPhysicalVolume* postVolume = step->GetPostStepPoint()->GetPhysicalVolume();
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+G4bool SteppingAction::EntersTank(const G4Step* step) const
+{
+	// volume roles are registered once in DetectorConstruction::Construct()
+	const VolumeRole preRole =
+		fDetector->GetVolumeRole(step->GetPreStepPoint()->GetPhysicalVolume());
+	const VolumeRole postRole =
+		fDetector->GetVolumeRole(step->GetPostStepPoint()->GetPhysicalVolume());
+	return preRole != VolumeRole::Tank && postRole == VolumeRole::Tank;
+}
 
-		//   Tank ɓJEg
-		if (preVolume && postVolume && preVolume->GetName() != "Tank" && postVolume->GetName() == "Tank")
-		{
-			run->IncrementAlphaCount(); // ̃JEg𑝂₷
-		}
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void SteppingAction::RegisterHandler(const G4ParticleDefinition* particle,
+	StepHandler handler)
+{
+	if (!particle) return;
+	const auto id = static_cast<std::size_t>(particle->GetInstanceID());
+	if (id >= fHandlers.size())
+	{
+		fHandlers.resize(id + 1, &SteppingAction::HandleDefault);
 	}
+	fHandlers[id] = handler;
+}
 
-	/////////////////////////////////////////////////////////////////////////////////////////
-	// betaoɓBƂJEg֐
-	/////////////////////////////////////////////////////////////////////////////////////////
-	static G4ParticleDefinition* betaParticle =
-		G4ParticleTable::GetParticleTable()->FindParticle("e-"); // betaidqj
-	static G4ParticleDefinition* positronParticle =
-		G4ParticleTable::GetParticleTable()->FindParticle("e+"); // beta_plusizdqj
+///----------------------------------------------------------------------------------------
+// XebsOANV֐
+///----------------------------------------------------------------------------------------
+void SteppingAction::UserSteppingAction(const G4Step* step)
+{
+	Run* run = fContext->GetRun();
 
-	if (particleDef == betaParticle || particleDef == positronParticle) // beta܂ beta_plus
+	// /opnovice2/stepping/benchmark: keep a copy before the handlers run
+	if (fBenchmark->IsRecording())
 	{
+		fBenchmark->Record(step);
+	}
 
-		G4VPhysicalVolume* preVolume = step->GetPreStepPoint()->GetPhysicalVolume();
-		G4VPhysicalVolume* postVolume = step->GetPostStepPoint()->GetPhysicalVolume();
-
-		/*
-		G4cout << "Beta Particle Step: PreVolume="
-			<< (preVolume ? preVolume->GetName() : "nullptr")
-			<< ", PostVolume="
-			<< (postVolume ? postVolume->GetName() : "nullptr")
-			<< G4endl;
-			*/
+	// photons split by the weight window join the secondaries of this step
+	fSecondaries = fpSteppingManager->GetfSecondary();
+	ProcessStep(step, run);
+	fSecondaries = nullptr;
 
+	if (fRoiActive)
+	{
+		KillOutsideRoi(step, run);
+	}
+}
 
-			//  beta Detector ɓJEg
-		if (preVolume && postVolume && preVolume->GetName() != "Tank" && postVolume->GetName() == "Tank")
-		{
-			//G4cout << "Beta entered Tank!" << G4endl;  // fobOo
-			run->IncrementBetaCount(); // betãJEg𑝂₷
-		}
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void SteppingAction::KillOutsideRoi(const G4Step* step, Run* run) const
+{
+	G4Track* track = step->GetTrack();
+	const G4StepPoint* endPoint = step->GetPostStepPoint();
+	// the placed volumes are all inside the envelope, so only steps ending
+	// in the world volume itself can leave it
+	if (track->GetTrackStatus() != fAlive || endPoint->GetPhysicalVolume() != fWorldVolume)
+	{
+		return;
+	}
+	const G4ParticleDefinition* particle = track->GetParticleDefinition();
+	if (!fRoi.Kills(particle) ||
+		!fRoi.IsEscaping(endPoint->GetPosition(), endPoint->GetMomentumDirection()))
+	{
+		return;
 	}
+	track->SetTrackStatus(fStopAndKill);
+	run->AddRoiKill(particle->GetParticleName(), track->GetKineticEnergy());
+}
 
-	////////////////////////////////////////////////////////////////////////////////////
-	// ʉ߃JEgǐoƓWbNɍ킹j
-	////////////////////////////////////////////////////////////////////////////////////
-	static G4ParticleDefinition* gammaParticle =
-		G4ParticleTable::GetParticleTable()->FindParticle("gamma");
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void SteppingAction::ProcessStep(const G4Step* step, Run* run)
+{
+	// one handler per particle type, registered in BeginOfRun(); particles
+	// without a handler (or created after the run started) get the default
+	// handler
+	const auto id = static_cast<std::size_t>(
+		step->GetTrack()->GetParticleDefinition()->GetInstanceID());
+	StepHandler handler =
+		id < fHandlers.size() ? fHandlers[id] : &SteppingAction::HandleDefault;
+	(this->*handler)(step, run);
+}
 
-	if (particleDef == gammaParticle) { // Ȃ
-		G4VPhysicalVolume* preVolume = step->GetPreStepPoint()->GetPhysicalVolume();
-		G4VPhysicalVolume* postVolume = step->GetPostStepPoint()->GetPhysicalVolume();
+/////////////////////////////////////////////////////////////////////////////////////////
+// qoɓBƂJEg֐
+/////////////////////////////////////////////////////////////////////////////////////////
+// The bookkeeping blocks are compiled in or out by the template policies,
+// see SelectOpticalHandler(); photon counting, kill-on-second-surface and
+// the group velocity check are common to all variants.
+template <G4bool kBoundaryStats, G4bool kWLSStats, G4bool kHistos>
+void SteppingAction::HandleOptical(const G4Step* step, Run* run)
+{
+	[[maybe_unused]] G4AnalysisManager* analysisMan = fContext->GetAnalysisManager();
 
-		//   Tank ɓuԁipreVolumeTankȊOApostVolumeTankjȂJEg
-		if (preVolume && postVolume &&
-			preVolume->GetName() != "Tank" && postVolume->GetName() == "Tank") {
-			run->IncrementGammaCount();
+	G4Track* track = step->GetTrack();
+	G4StepPoint* endPoint = step->GetPostStepPoint();
+	[[maybe_unused]] G4StepPoint* startPoint = step->GetPreStepPoint();
+	auto trackInfo = (TrackInformation*)(track->GetUserInformation());
+	const G4double weight = trackInfo->GetWeight();
 
-			//G4cout << "gamma entered Tank!" << G4endl;  // fobOo
-		}
+	// past the time gate: can no longer contribute to the pulse
+	if (fTimeGate > 0. && track->GetGlobalTime() > fTimeGate)
+	{
+		track->SetTrackStatus(fStopAndKill);
+		run->AddOutOfGate(weight);
+		return;
 	}
 
-
-	/////////////////////////////////////////////////////////////////////////////////////////
-	// qoɓBƂJEg֐
-	/////////////////////////////////////////////////////////////////////////////////////////
-	if (particleDef == opticalphoton)
+	if (EntersTank(step))
 	{
-		G4VPhysicalVolume* preVolume = step->GetPreStepPoint()->GetPhysicalVolume();
-		G4VPhysicalVolume* postVolume = step->GetPostStepPoint()->GetPhysicalVolume();
-		G4StepPoint* startPoint = step->GetPreStepPoint();
-		G4StepStatus startStatus = startPoint->GetStepStatus();
+		run->AddPhotonArrival(track->GetGlobalTime(), weight);
+	}
 
-		if (preVolume && postVolume && preVolume->GetName() != "Tank" && postVolume->GetName() == "Tank")
-		{
-			run->AddPhotonCount();
-		}
-		/*
-
-			if(startStatus == fGeomBoundary && preVolume && preVolume->GetName() == "Tank_Plastic" && postVolume && postVolume->GetName() == "Reflector")
-			 {
-			  run->AddPhotonCountZP();
-			 }
-			//else if(preVolume && postVolume && preVolume->GetName() == "World" && postVolume->GetName() == "World")
-			 //{
-			 // run->AddPhotonCountZW();
-			 //}
-			else if(preVolume && postVolume && preVolume->GetName() == "Tank_Plastic" && postVolume->GetName() == "Tank_Plastic")
-			 {
-			  run->AddPhotonCountZP();
-			 }
-			else if(preVolume && postVolume && preVolume->GetName() == "Tank_Plastic" && postVolume->GetName() == "Reflector")
-			 {
-			  run->AddPhotonCountZP();
-			 }
-
-			else if(preVolume && postVolume && preVolume->GetName() == "Tank_ZnS" && postVolume->GetName() == "Tank_ZnS")
-			 {
-			  run->AddPhotonCountPZ();
-			 }
-		*/
-		const G4VProcess* pds = endPoint->GetProcessDefinedStep();
-		G4String procname = pds->GetProcessName();
-
-		if (procname == "OpAbsorption")
+	const G4VProcess* pds = endPoint->GetProcessDefinedStep();
+
+	if constexpr (kBoundaryStats)
+	{
+		if (pds == fAbsorptionProcess)
 		{
-			run->AddOpAbsorption();
+			run->AddOpAbsorption(weight);
 			if (trackInfo->GetIsFirstTankX())
 			{
-				run->AddOpAbsorptionPrior();
+				run->AddOpAbsorptionPrior(weight);
 			}
 		}
-		else if (procname == "OpRayleigh")
+		else if (pds == fRayleighProcess)
 		{
-			run->AddRayleigh();
+			run->AddRayleigh(weight);
 		}
-		else if (procname == "OpWLS")
+	}
+
+	if constexpr (kWLSStats)
+	{
+		if (pds == fWLSProcess)
 		{
 			G4double en = track->GetKineticEnergy();
-			run->AddWLSAbsorption();
-			run->AddWLSAbsorptionEnergy(en);
-			analysisMan->FillH1(4, en / eV);  // absorption energy
+			run->AddWLSAbsorption(weight);
+			run->AddWLSAbsorptionEnergy(en, weight);
+			if constexpr (kHistos) analysisMan->FillH1(4, en / eV, weight);  // absorption energy
 			// loop over secondaries, create statistics
-			// const std::vector<const G4Track*>* secondaries =
 			auto secondaries = step->GetSecondaryInCurrentStep();
 			for (auto sec : *secondaries)
 			{
 				en = sec->GetKineticEnergy();
-				run->AddWLSEmission();
-				run->AddWLSEmissionEnergy(en);
-				analysisMan->FillH1(5, en / eV);  // emission energy
-				G4double time = sec->GetGlobalTime();
-				analysisMan->FillH1(6, time / ns);
+				run->AddWLSEmission(weight);
+				run->AddWLSEmissionEnergy(en, weight);
+				if constexpr (kHistos)
+				{
+					analysisMan->FillH1(5, en / eV, weight);  // emission energy
+					G4double time = sec->GetGlobalTime();
+					analysisMan->FillH1(6, time / ns, weight);
+				}
 			}
 		}
-		else if (procname == "OpWLS2")
+		else if (pds == fWLS2Process)
 		{
 			G4double en = track->GetKineticEnergy();
-			run->AddWLS2Absorption();
-			run->AddWLS2AbsorptionEnergy(en);
-			analysisMan->FillH1(7, en / eV);  // absorption energy
+			run->AddWLS2Absorption(weight);
+			run->AddWLS2AbsorptionEnergy(en, weight);
+			if constexpr (kHistos) analysisMan->FillH1(7, en / eV, weight);  // absorption energy
 			// loop over secondaries, create statistics
-			// const std::vector<const G4Track*>* secondaries =
 			auto secondaries = step->GetSecondaryInCurrentStep();
 			for (auto sec : *secondaries)
 			{
 				en = sec->GetKineticEnergy();
-				run->AddWLS2Emission();
-				run->AddWLS2EmissionEnergy(en);
-				analysisMan->FillH1(8, en / eV);  // emission energy
-				G4double time = sec->GetGlobalTime();
-				analysisMan->FillH1(9, time / ns);
+				run->AddWLS2Emission(weight);
+				run->AddWLS2EmissionEnergy(en, weight);
+				if constexpr (kHistos)
+				{
+					analysisMan->FillH1(8, en / eV, weight);  // emission energy
+					G4double time = sec->GetGlobalTime();
+					analysisMan->FillH1(9, time / ns, weight);
+				}
 			}
 		}
+	}
 
-		// optical process has endpt on bdry,
-		if (endPoint->GetStepStatus() == fGeomBoundary)
+	// optical process has endpt on bdry,
+	if (endPoint->GetStepStatus() == fGeomBoundary)
+	{
+		if constexpr (kBoundaryStats)
 		{
-			G4ThreeVector p0 = startPoint->GetMomentumDirection();
-			G4ThreeVector p1 = endPoint->GetMomentumDirection();
-
-			G4OpBoundaryProcessStatus theStatus = Undefined;
-
-			G4ProcessManager* OpManager = opticalphoton->GetProcessManager();
-			G4ProcessVector* postStepDoItVector =
-				OpManager->GetPostStepProcessVector(typeDoIt);
-			G4int n_proc = postStepDoItVector->entries();
-
 			if (trackInfo->GetIsFirstTankX())
 			{
+				G4ThreeVector p0 = startPoint->GetMomentumDirection();
+				G4ThreeVector p1 = endPoint->GetMomentumDirection();
 				G4double px1 = p1.x();
 				G4double py1 = p1.y();
 				G4double pz1 = p1.z();
 				// do not count Absorbed or Detected photons here
-				if (track->GetTrackStatus() != fStopAndKill)
+				if (kHistos && track->GetTrackStatus() != fStopAndKill)
 				{
 					if (px1 < 0.)
 					{
-						analysisMan->FillH1(11, px1);
-						analysisMan->FillH1(12, py1);
-						analysisMan->FillH1(13, pz1);
+						analysisMan->FillH1(11, px1, weight);
+						analysisMan->FillH1(12, py1, weight);
+						analysisMan->FillH1(13, pz1, weight);
 					}
 					else
 					{
-						analysisMan->FillH1(14, px1);
-						analysisMan->FillH1(15, py1);
-						analysisMan->FillH1(16, pz1);
+						analysisMan->FillH1(14, px1, weight);
+						analysisMan->FillH1(15, py1, weight);
+						analysisMan->FillH1(16, pz1, weight);
 					}
 				}
 
 				trackInfo->SetIsFirstTankX(false);
-				run->AddTotalSurface();
+				run->AddTotalSurface(weight);
 
-				for (G4int i = 0; i < n_proc; ++i)
+				if (fBoundaryProcess)
 				{
-					G4VProcess* currentProcess = (*postStepDoItVector)[i];
+					G4OpBoundaryProcessStatus theStatus = GetBoundaryStatus();
+					run->AddBoundaryStatus(theStatus, weight);
 
-					auto opProc = dynamic_cast<G4OpBoundaryProcess*>(currentProcess);
-					if (opProc)
+					if (kHistos && static_cast<std::size_t>(theStatus) < fBoundaryHistos.size())
 					{
-						G4double angle = std::acos(p0.x());
-						theStatus = opProc->GetStatus();
-						analysisMan->FillH1(10, theStatus);
-						switch (theStatus)
+						analysisMan->FillH1(10, theStatus, weight);
+
+						const BoundaryHistos& histos = fBoundaryHistos[theStatus];
+						if (histos.angle[0] >= 0)
 						{
-						case Transmission:
-							run->AddTransmission();
-							analysisMan->FillH1(25, angle / deg);
-							break;
-						case FresnelRefraction:
-							run->AddFresnelRefraction();
-							analysisMan->FillH1(17, px1);
-							analysisMan->FillH1(18, py1);
-							analysisMan->FillH1(19, pz1);
-							analysisMan->FillH1(20, angle / deg);
-							break;
-						case FresnelReflection:
-							run->AddFresnelReflection();
-							analysisMan->FillH1(21, angle / deg);
-							analysisMan->FillH1(23, angle / deg);
-							break;
-						case TotalInternalReflection:
-							run->AddTotalInternalReflection();
-							analysisMan->FillH1(22, angle / deg);
-							analysisMan->FillH1(23, angle / deg);
-							break;
-						case LambertianReflection:
-							run->AddLambertianReflection();
-							break;
-						case LobeReflection:
-							run->AddLobeReflection();
-							break;
-						case SpikeReflection:
-							run->AddSpikeReflection();
-							analysisMan->FillH1(26, angle / deg);
-							break;
-						case BackScattering:
-							run->AddBackScattering();
-							break;
-						case Absorption:
-							analysisMan->FillH1(24, angle / deg);
-							run->AddAbsorption();
-							break;
-						case Detection:
-							run->AddDetection();
-							break;
-						case NotAtBoundary:
-							run->AddNotAtBoundary();
-							break;
-						case SameMaterial:
-							run->AddSameMaterial();
-							break;
-						case StepTooSmall:
-							run->AddStepTooSmall();
-							break;
-						case NoRINDEX:
-							run->AddNoRINDEX();
-							break;
-						case PolishedLumirrorAirReflection:
-							run->AddPolishedLumirrorAirReflection();
-							break;
-						case PolishedLumirrorGlueReflection:
-							run->AddPolishedLumirrorGlueReflection();
-							break;
-						case PolishedAirReflection:
-							run->AddPolishedAirReflection();
-							break;
-						case PolishedTeflonAirReflection:
-							run->AddPolishedTeflonAirReflection();
-							break;
-						case PolishedTiOAirReflection:
-							run->AddPolishedTiOAirReflection();
-							break;
-						case PolishedTyvekAirReflection:
-							run->AddPolishedTyvekAirReflection();
-							break;
-						case PolishedVM2000AirReflection:
-							run->AddPolishedVM2000AirReflection();
-							break;
-						case PolishedVM2000GlueReflection:
-							run->AddPolishedVM2000AirReflection();
-							break;
-						case EtchedLumirrorAirReflection:
-							run->AddEtchedLumirrorAirReflection();
-							break;
-						case EtchedLumirrorGlueReflection:
-							run->AddEtchedLumirrorGlueReflection();
-							break;
-						case EtchedAirReflection:
-							run->AddEtchedAirReflection();
-							break;
-						case EtchedTeflonAirReflection:
-							run->AddEtchedTeflonAirReflection();
-							break;
-						case EtchedTiOAirReflection:
-							run->AddEtchedTiOAirReflection();
-							break;
-						case EtchedTyvekAirReflection:
-							run->AddEtchedTyvekAirReflection();
-							break;
-						case EtchedVM2000AirReflection:
-							run->AddEtchedVM2000AirReflection();
-							break;
-						case EtchedVM2000GlueReflection:
-							run->AddEtchedVM2000AirReflection();
-							break;
-						case GroundLumirrorAirReflection:
-							run->AddGroundLumirrorAirReflection();
-							break;
-						case GroundLumirrorGlueReflection:
-							run->AddGroundLumirrorGlueReflection();
-							break;
-						case GroundAirReflection:
-							run->AddGroundAirReflection();
-							break;
-						case GroundTeflonAirReflection:
-							run->AddGroundTeflonAirReflection();
-							break;
-						case GroundTiOAirReflection:
-							run->AddGroundTiOAirReflection();
-							break;
-						case GroundTyvekAirReflection:
-							run->AddGroundTyvekAirReflection();
-							break;
-						case GroundVM2000AirReflection:
-							run->AddGroundVM2000AirReflection();
-							break;
-						case GroundVM2000GlueReflection:
-							run->AddGroundVM2000AirReflection();
-							break;
-						case Dichroic:
-							run->AddDichroic();
-							break;
-						case CoatedDielectricReflection:
-							run->AddCoatedDielectricReflection();
-							break;
-						case CoatedDielectricRefraction:
-							run->AddCoatedDielectricRefraction();
-							break;
-						case CoatedDielectricFrustratedTransmission:
-							run->AddCoatedDielectricFrustratedTransmission();
-							break;
-						default:
-							G4cout << "theStatus: " << theStatus
-								<< " was none of the above." << G4endl;
-							break;
+							G4double angle = std::acos(p0.x());
+							for (G4int id : histos.angle)
+							{
+								if (id >= 0) analysisMan->FillH1(id, angle / deg, weight);
+							}
+						}
+						if (histos.direction)
+						{
+							analysisMan->FillH1(17, px1, weight);
+							analysisMan->FillH1(18, py1, weight);
+							analysisMan->FillH1(19, pz1, weight);
 						}
 					}
 				}
 			}
-			// when studying boundary scattering, it can be useful to only
-			// visualize the photon before and after the first surface. If
-			// selected, kill the photon when reaching the second surface
-			// (note that there are 2 steps at the boundary, so the counter
-			// equals 0 and 1 on the first surface)
-			if (fKillOnSecondSurface) {
-				if (trackInfo->GetReflectionNumber() >= 2) {
-					track->SetTrackStatus(fStopAndKill);
-				}
-			}
-			trackInfo->IncrementReflectionNumber();
 		}
-
-		// This block serves to test that G4OpBoundaryProcess sets the group
-		// velocity correctly. It is not necessary to include in user code.
-		// Only steps where pre- and post- are the same material, to avoid
-		// incorrect checks (so, in practice, set e.g. OpRayleigh low enough
-		// for particles to step in the interior of each volume.
-		if (endPoint->GetMaterial() == startPoint->GetMaterial())
-		{
-			G4double trackVelocity = track->GetVelocity();
-			G4double materialVelocity = CLHEP::c_light;
-			G4MaterialPropertyVector* velVector = endPoint->GetMaterial()
-				->GetMaterialPropertiesTable()->GetProperty(kGROUPVEL);
-			if (velVector)
-			{
-				materialVelocity =
-					velVector->Value(theParticle->GetTotalMomentum(), fIdxVelocity);
-			}
-
-			if (std::abs(trackVelocity - materialVelocity) > 1e-9 * CLHEP::c_light)
-			{
-				G4ExceptionDescription ed;
-				ed << "Optical photon group velocity: " << trackVelocity / (cm / ns)
-					<< " cm/ns is not what is expected from " << G4endl
-					<< "the material properties, "
-					<< materialVelocity / (cm / ns) << " cm/ns";
-				G4Exception("OpNovice2 SteppingAction", "OpNovice2_1",
-					FatalException, ed);
+		// when studying boundary scattering, it can be useful to only
+		// visualize the photon before and after the first surface. If
+		// selected, kill the photon when reaching the second surface
+		// (note that there are 2 steps at the boundary, so the counter
+		// equals 0 and 1 on the first surface)
+		if (fKillOnSecondSurface) {
+			if (trackInfo->GetReflectionNumber() >= 2) {
+				track->SetTrackStatus(fStopAndKill);
 			}
 		}
-		// end of group velocity test
-	}
+		trackInfo->IncrementReflectionNumber();
 
-	else
-	{  // particle != opticalphoton
-	  // print how many Cerenkov and scint photons produced this step
-	  // this demonstrates use of GetNumPhotons()
-		auto proc_man =
-			track->GetDynamicParticle()->GetParticleDefinition()->GetProcessManager();
-		G4ProcessVector* proc_vec = proc_man->GetPostStepProcessVector(typeDoIt);
-		G4int n_proc = proc_vec->entries();
-
-		G4int n_scint = 0;
-		G4int n_cer = 0;
-		for (G4int i = 0; i < n_proc; ++i)
+		if (fWeightWindow)
 		{
-			G4String proc_name = (*proc_vec)[i]->GetProcessName();
-
-			if (proc_name == "Scintillation")
-			{
-				auto scint = (G4Scintillation*)(*proc_vec)[i];
-				n_scint = scint->GetNumPhotons();
-			}
-
-			/*
-			if(proc_name == "Cerenkov")
-			{
-			  auto cer = (G4Cerenkov*) (*proc_vec)[i];
-			  n_cer    = cer->GetNumPhotons();
-			}
-			else if(proc_name == "Scintillation")
-			{
-			  auto scint = (G4Scintillation*) (*proc_vec)[i];
-			  n_scint    = scint->GetNumPhotons();
-			}*/
-		}
-		if (fVerbose > 0)
-		{
-			if (n_cer > 0 || n_scint > 0)
-			{
-				G4cout << "In this step, " << n_cer << " Cerenkov and " << n_scint
-					<< " scintillation photons were produced." << G4endl;
-			}
+			ApplyWeightWindow(step, trackInfo);
 		}
+	}
 
-		// loop over secondaries, create statistics
-		const std::vector<const G4Track*>* secondaries =
-			step->GetSecondaryInCurrentStep();
+	// group velocity self-test, off by default; see CheckGroupVelocity()
+	if (fGroupVelocityCheck == GroupVelocityCheck::Always
+		|| (fGroupVelocityCheck == GroupVelocityCheck::Sampled
+			&& ++fGroupVelocityStepCount % fGroupVelocitySampling == 0))
+	{
+		CheckGroupVelocity(step, run);
+	}
+}
 
-		for (auto sec : *secondaries)
-		{
-			if (sec->GetDynamicParticle()->GetParticleDefinition() == opticalphoton)
-			{
-				G4String creator_process = sec->GetCreatorProcess()->GetProcessName();
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void SteppingAction::ApplyWeightWindow(const G4Step* step, TrackInformation* trackInfo)
+{
+	G4Track* track = step->GetTrack();
+	const G4VPhysicalVolume* postVolume = step->GetPostStepPoint()->GetPhysicalVolume();
+	if (!postVolume || track->GetTrackStatus() == fStopAndKill) return;
 
+	// the post-step volume is the one across the surface, also when the
+	// photon is reflected back; only a crossing changes the importance
+	if (fBoundaryProcess)
+	{
+		const G4OpBoundaryProcessStatus status = GetBoundaryStatus();
+		if (status != FresnelRefraction && status != Transmission && status != SameMaterial) return;
+	}
 
-				if (creator_process == "Scintillation")
-				{
-					G4double en = sec->GetKineticEnergy();
-					run->AddScintillationEnergy(en);
-					run->AddScintillation();
-					analysisMan->FillH1(2, en / eV);
+	auto importance = [this](const G4VPhysicalVolume* pv) {
+		const auto id = static_cast<std::size_t>(pv->GetLogicalVolume()->GetInstanceID());
+		return id < fImportance.size() ? fImportance[id] : 1.;
+	};
+	const G4double ratio =
+		importance(postVolume) / importance(step->GetPreStepPoint()->GetPhysicalVolume());
+	if (ratio == 1.) return;
 
-					G4double time = sec->GetGlobalTime();
-					analysisMan->FillH1(3, time / ns);
-				}
+	const G4double weight = trackInfo->GetWeight();
+	if (ratio < 1.)
+	{
+		// Russian roulette
+		if (G4UniformRand() < ratio)
+			trackInfo->SetWeight(weight / ratio);
+		else
+			track->SetTrackStatus(fStopAndKill);
+		return;
+	}
 
+	// split into n photons, n = ratio on average; the total weight is kept
+	// whatever n is drawn. Nothing to add to while replaying (StepBenchmark).
+	const G4int maxSplit = 100;
+	G4int n = static_cast<G4int>(ratio);
+	if (G4UniformRand() < ratio - n) ++n;
+	n = std::min(n, maxSplit);
+	if (n <= 1 || !fSecondaries) return;
 
+	trackInfo->SetWeight(weight / n);
+	for (G4int i = 1; i < n; ++i)
+	{
+		auto copy = new G4Track(new G4DynamicParticle(*track->GetDynamicParticle()),
+			track->GetGlobalTime(), track->GetPosition());
+		copy->SetParentID(track->GetTrackID());
+		copy->SetTouchableHandle(track->GetNextTouchableHandle());
+		// no creator process, so that StackingAction does not count the
+		// copy as a created photon
+		auto info = new TrackInformation(trackInfo);
+		info->SetReflectionNumber(trackInfo->GetReflectionNumber());
+		info->SetSplitCopy(true);
+		copy->SetUserInformation(info);
+		fSecondaries->push_back(copy);
+	}
+}
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void SteppingAction::CheckGroupVelocity(const G4Step* step, Run* run)
+{
+	// This block serves to test that G4OpBoundaryProcess sets the group
+	// velocity correctly. It is not necessary to include in user code.
+	// Only steps where pre- and post- are the same material, to avoid
+	// incorrect checks (so, in practice, set e.g. OpRayleigh low enough
+	// for particles to step in the interior of each volume.
+	const G4StepPoint* startPoint = step->GetPreStepPoint();
+	const G4StepPoint* endPoint = step->GetPostStepPoint();
+	if (endPoint->GetMaterial() != startPoint->GetMaterial())
+	{
+		return;
+	}
 
+	const G4Track* track = step->GetTrack();
+	G4double trackVelocity = track->GetVelocity();
+	G4double materialVelocity = CLHEP::c_light;
+	const G4double energy = track->GetDynamicParticle()->GetTotalMomentum();
+	const G4MaterialPropertiesTable* mpt =
+		endPoint->GetMaterial()->GetMaterialPropertiesTable();
+	G4MaterialPropertyVector* velVector =
+		mpt ? mpt->GetProperty(kGROUPVEL) : nullptr;
+	if (velVector)
+	{
+		materialVelocity = velVector->Value(energy, fIdxVelocity);
+	}
 
+	// the uniform-grid GROUPVEL is checked against the same exact value,
+	// but reported on its own
+	const UniformTable* velTable = fDetector->GetOpticalTables().Get(
+		endPoint->GetMaterial(), OpticalTables::kGroupVel);
+	if (velTable && velVector)
+	{
+		run->AddGroupVelocityTableDeviation(std::abs(velTable->Value(energy) - materialVelocity));
+	}
 
-				/*
-				if(creator_process == "Cerenkov")
-				{
-				  G4double en = sec->GetKineticEnergy();
-				  run->AddCerenkovEnergy(en);
-				  run->AddCerenkov();
-				  analysisMan->FillH1(1, en / eV);
-				}
-				else if(creator_process == "Scintillation")
-				{
-				  G4double en = sec->GetKineticEnergy();
-				  run->AddScintillationEnergy(en);
-				  run->AddScintillation();
-				  analysisMan->FillH1(2, en / eV);
+	run->AddGroupVelocityCheck();
+	if (std::abs(trackVelocity - materialVelocity) > 1e-9 * CLHEP::c_light)
+	{
+		run->AddGroupVelocityViolation();
 
-				  G4double time = sec->GetGlobalTime();
-				  analysisMan->FillH1(3, time / ns);
+		// report the first violation of the run on this thread; the total
+		// is printed at the end of run
+		if (fGroupVelocityFatal || run->GetGroupVelocityViolations() == 1)
+		{
+			G4ExceptionDescription ed;
+			ed << "Optical photon group velocity: " << trackVelocity / (cm / ns)
+				<< " cm/ns is not what is expected from " << G4endl
+				<< "the material properties, "
+				<< materialVelocity / (cm / ns) << " cm/ns";
+			G4Exception("OpNovice2 SteppingAction", "OpNovice2_1",
+				fGroupVelocityFatal ? FatalException : JustWarning, ed);
+		}
+	}
+}
 
-				}*/
-			}
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+void SteppingAction::HandleDefault(const G4Step*, Run*)
+{
+	// print how many Cerenkov and scint photons produced this step
+	// this demonstrates use of GetNumPhotons(); only done on request
+	// (/opnovice2/stepping/verbose) since it runs for every charged step
+	if (fVerbose > 0)
+	{
+		G4int n_scint = fScintProcess ? fScintProcess->GetNumPhotons() : 0;
+		G4int n_cer = fCerenkovProcess ? fCerenkovProcess->GetNumPhotons() : 0;
+		if (n_cer > 0 || n_scint > 0)
+		{
+			G4cout << "In this step, " << n_cer << " Cerenkov and " << n_scint
+				<< " scintillation photons were produced." << G4endl;
 		}
 	}
 
-	return;
+	// created Cerenkov/scintillation photons are counted in
+	// StackingAction::ClassifyNewTrack()
 }
 
 
@@ -32,8 +32,16 @@
 
 #include "SteppingMessenger.hh"
 #include "SteppingAction.hh"
+#include "StepBenchmark.hh"
 #include "G4UIdirectory.hh"
 #include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -51,6 +59,152 @@ SteppingMessenger::SteppingMessenger(SteppingAction* steppingAction)
     "Useful for visualizing boundary scattering.");
   fKillOnSecondSurfaceCmd->SetDefaultValue(false);
   fKillOnSecondSurfaceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fBoundaryStatsCmd =
+    new G4UIcmdWithABool("/opnovice2/stepping/boundaryStats", this);
+  fBoundaryStatsCmd->SetGuidance(
+    "Record boundary status, first-surface and bulk absorption/Rayleigh "
+    "statistics of optical photons. Takes effect at the next run.");
+  fBoundaryStatsCmd->SetDefaultValue(true);
+  fBoundaryStatsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fWLSStatsCmd = new G4UIcmdWithABool("/opnovice2/stepping/wlsStats", this);
+  fWLSStatsCmd->SetGuidance(
+    "Record WLS and WLS2 absorption/emission statistics. "
+    "Takes effect at the next run.");
+  fWLSStatsCmd->SetDefaultValue(true);
+  fWLSStatsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fHistogramsCmd =
+    new G4UIcmdWithABool("/opnovice2/stepping/histograms", this);
+  fHistogramsCmd->SetGuidance(
+    "Fill the optical photon histograms 4-26. Takes effect at the next run.");
+  fHistogramsCmd->SetDefaultValue(true);
+  fHistogramsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fVerboseCmd = new G4UIcmdWithAnInteger("/opnovice2/stepping/verbose", this);
+  fVerboseCmd->SetGuidance("Stepping verbose level.");
+  fVerboseCmd->SetGuidance(
+    "> 0 prints the number of Cerenkov and scintillation photons "
+    "produced in each step.");
+  fVerboseCmd->SetParameterName("verbose", true);
+  fVerboseCmd->SetDefaultValue(0);
+  fVerboseCmd->SetRange("verbose >= 0");
+  fVerboseCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fBenchmarkCmd =
+    new G4UIcmdWithAnInteger("/opnovice2/stepping/benchmark", this);
+  fBenchmarkCmd->SetGuidance(
+    "Record up to N steps per branch (optical boundary, optical WLS, "
+    "optical bulk, charged with secondaries, Tank entry) during the next "
+    "run and replay them at its end, printing the cost in ns/step.");
+  fBenchmarkCmd->SetGuidance("0 disables the benchmark (default).");
+  fBenchmarkCmd->SetParameterName("N", false);
+  fBenchmarkCmd->SetRange("N >= 0");
+  fBenchmarkCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fBenchmarkRepeatCmd =
+    new G4UIcmdWithAnInteger("/opnovice2/stepping/benchmarkRepeat", this);
+  fBenchmarkRepeatCmd->SetGuidance(
+    "Number of times the recorded steps are replayed (default 100).");
+  fBenchmarkRepeatCmd->SetParameterName("R", false);
+  fBenchmarkRepeatCmd->SetRange("R >= 1");
+  fBenchmarkRepeatCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fGroupVelocityCheckCmd =
+    new G4UIcmdWithAString("/opnovice2/stepping/groupVelocityCheck", this);
+  fGroupVelocityCheckCmd->SetGuidance(
+    "Check the optical photon velocity against the GROUPVEL property.");
+  fGroupVelocityCheckCmd->SetGuidance(
+    "  off     : no check (default)");
+  fGroupVelocityCheckCmd->SetGuidance(
+    "  sampled : check one optical step in N (see groupVelocitySampling)");
+  fGroupVelocityCheckCmd->SetGuidance(
+    "  always  : check every optical step");
+  fGroupVelocityCheckCmd->SetParameterName("mode", false);
+  fGroupVelocityCheckCmd->SetCandidates("off sampled always");
+  fGroupVelocityCheckCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fGroupVelocitySamplingCmd =
+    new G4UIcmdWithAnInteger("/opnovice2/stepping/groupVelocitySampling", this);
+  fGroupVelocitySamplingCmd->SetGuidance(
+    "Check one optical step in N in sampled mode.");
+  fGroupVelocitySamplingCmd->SetParameterName("N", false);
+  fGroupVelocitySamplingCmd->SetRange("N >= 1");
+  fGroupVelocitySamplingCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fGroupVelocityFatalCmd =
+    new G4UIcmdWithABool("/opnovice2/stepping/groupVelocityFatal", this);
+  fGroupVelocityFatalCmd->SetGuidance(
+    "Abort the run on a group velocity violation instead of counting it.");
+  fGroupVelocityFatalCmd->SetDefaultValue(true);
+  fGroupVelocityFatalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fWeightWindowCmd =
+    new G4UIcmdWithABool("/opnovice2/stepping/weightWindow", this);
+  fWeightWindowCmd->SetGuidance(
+    "Russian roulette / splitting of optical photons crossing between");
+  fWeightWindowCmd->SetGuidance(
+    "volumes of different importance (see importance); all photon counters");
+  fWeightWindowCmd->SetGuidance("are then weighted.");
+  fWeightWindowCmd->SetDefaultValue(true);
+  fWeightWindowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fImportanceCmd = new G4UIcommand("/opnovice2/stepping/importance", this);
+  fImportanceCmd->SetGuidance(
+    "Optical photon importance of a logical volume (default 1).");
+  fImportanceCmd->SetGuidance(
+    "Photons entering a volume of lower importance are rouletted, those");
+  fImportanceCmd->SetGuidance("entering one of higher importance are split.");
+  auto volumeParam = new G4UIparameter("volume", 's', false);
+  fImportanceCmd->SetParameter(volumeParam);
+  auto importanceParam = new G4UIparameter("importance", 'd', false);
+  importanceParam->SetParameterRange("importance > 0");
+  fImportanceCmd->SetParameter(importanceParam);
+  fImportanceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fTimeGateCmd =
+    new G4UIcmdWithADoubleAndUnit("/opnovice2/stepping/timeGate", this);
+  fTimeGateCmd->SetGuidance(
+    "Kill the optical photons created or propagated past this global time");
+  fTimeGateCmd->SetGuidance(
+    "and count them as out of gate. Taken at the start of each run;");
+  fTimeGateCmd->SetGuidance("0 disables it (default).");
+  fTimeGateCmd->SetParameterName("gate", false);
+  fTimeGateCmd->SetRange("gate >= 0");
+  fTimeGateCmd->SetDefaultUnit("ns");
+  fTimeGateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fRoiDir = new G4UIdirectory("/opnovice2/roi/");
+  fRoiDir->SetGuidance("Region-of-interest envelope around the placed volumes");
+
+  fRoiEnableCmd = new G4UIcmdWithABool("/opnovice2/roi/enable", this);
+  fRoiEnableCmd->SetGuidance(
+    "Stop the tracks that are outside the envelope and moving away from it.");
+  fRoiEnableCmd->SetGuidance(
+    "The envelope is the bounding box of the daughters of the world plus");
+  fRoiEnableCmd->SetGuidance("the margin, computed at the start of each run.");
+  fRoiEnableCmd->SetDefaultValue(true);
+  fRoiEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fRoiMarginCmd =
+    new G4UIcmdWithADoubleAndUnit("/opnovice2/roi/margin", this);
+  fRoiMarginCmd->SetGuidance("Margin added around the placed volumes.");
+  fRoiMarginCmd->SetParameterName("margin", false);
+  fRoiMarginCmd->SetRange("margin >= 0");
+  fRoiMarginCmd->SetDefaultUnit("cm");
+  fRoiMarginCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fRoiKillCmd = new G4UIcommand("/opnovice2/roi/kill", this);
+  fRoiKillCmd->SetGuidance(
+    "Kill policy of a particle type leaving the envelope (default: all");
+  fRoiKillCmd->SetGuidance(
+    "particles are killed). \"all\" sets the policy of every type.");
+  auto particleParam = new G4UIparameter("particle", 's', false);
+  fRoiKillCmd->SetParameter(particleParam);
+  auto killParam = new G4UIparameter("kill", 'b', false);
+  fRoiKillCmd->SetParameter(killParam);
+  fRoiKillCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -59,6 +213,22 @@ SteppingMessenger::~SteppingMessenger()
 {
   delete fSteppingDir;
   delete fKillOnSecondSurfaceCmd;
+  delete fBoundaryStatsCmd;
+  delete fWLSStatsCmd;
+  delete fHistogramsCmd;
+  delete fVerboseCmd;
+  delete fBenchmarkCmd;
+  delete fBenchmarkRepeatCmd;
+  delete fGroupVelocityCheckCmd;
+  delete fGroupVelocitySamplingCmd;
+  delete fGroupVelocityFatalCmd;
+  delete fWeightWindowCmd;
+  delete fImportanceCmd;
+  delete fTimeGateCmd;
+  delete fRoiEnableCmd;
+  delete fRoiMarginCmd;
+  delete fRoiKillCmd;
+  delete fRoiDir;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -71,6 +241,89 @@ void SteppingMessenger::SetNewValue(G4UIcommand* command,
     fSteppingAction->SetKillOnSecondSurface(
       G4UIcmdWithABool::GetNewBoolValue(newValue));
   }
+  else if(command == fBoundaryStatsCmd)
+  {
+    fSteppingAction->SetBoundaryStats(
+      G4UIcmdWithABool::GetNewBoolValue(newValue));
+  }
+  else if(command == fWLSStatsCmd)
+  {
+    fSteppingAction->SetWLSStats(G4UIcmdWithABool::GetNewBoolValue(newValue));
+  }
+  else if(command == fHistogramsCmd)
+  {
+    fSteppingAction->SetHistograms(
+      G4UIcmdWithABool::GetNewBoolValue(newValue));
+  }
+  else if(command == fVerboseCmd)
+  {
+    fSteppingAction->SetVerbose(
+      G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+  }
+  else if(command == fBenchmarkCmd)
+  {
+    fSteppingAction->GetBenchmark()->SetMaxSteps(
+      G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+  }
+  else if(command == fBenchmarkRepeatCmd)
+  {
+    fSteppingAction->GetBenchmark()->SetRepetitions(
+      G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+  }
+  else if(command == fGroupVelocityCheckCmd)
+  {
+    GroupVelocityCheck mode = GroupVelocityCheck::Off;
+    if(newValue == "sampled")
+      mode = GroupVelocityCheck::Sampled;
+    else if(newValue == "always")
+      mode = GroupVelocityCheck::Always;
+    fSteppingAction->SetGroupVelocityCheck(mode);
+  }
+  else if(command == fGroupVelocitySamplingCmd)
+  {
+    fSteppingAction->SetGroupVelocitySampling(
+      G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+  }
+  else if(command == fGroupVelocityFatalCmd)
+  {
+    fSteppingAction->SetGroupVelocityFatal(
+      G4UIcmdWithABool::GetNewBoolValue(newValue));
+  }
+  else if(command == fWeightWindowCmd)
+  {
+    fSteppingAction->SetWeightWindow(
+      G4UIcmdWithABool::GetNewBoolValue(newValue));
+  }
+  else if(command == fImportanceCmd)
+  {
+    std::istringstream is(newValue);
+    G4String volume;
+    G4double importance = 1.;
+    is >> volume >> importance;
+    fSteppingAction->SetImportance(volume, importance);
+  }
+  else if(command == fTimeGateCmd)
+  {
+    fSteppingAction->SetTimeGate(fTimeGateCmd->GetNewDoubleValue(newValue));
+  }
+  else if(command == fRoiEnableCmd)
+  {
+    fSteppingAction->GetRoiEnvelope().SetEnabled(
+      G4UIcmdWithABool::GetNewBoolValue(newValue));
+  }
+  else if(command == fRoiMarginCmd)
+  {
+    fSteppingAction->GetRoiEnvelope().SetMargin(
+      fRoiMarginCmd->GetNewDoubleValue(newValue));
+  }
+  else if(command == fRoiKillCmd)
+  {
+    std::istringstream is(newValue);
+    G4String particle, kill;
+    is >> particle >> kill;
+    fSteppingAction->GetRoiEnvelope().SetKill(
+      particle, G4UIcommand::ConvertToBool(kill));
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,114 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file optical/OpNovice2/src/TankSD.cc
+/// \brief Implementation of the TankSD class
+//
+//
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#include "TankSD.hh"
+
+#include "TrackInformation.hh"
+
+#include "G4Alpha.hh"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4Positron.hh"
+#include "G4SDManager.hh"
+#include "G4Step.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TankSD::TankSD(const G4String& name)
+  : G4VSensitiveDetector(name)
+{
+  // the order follows the Species enum
+  collectionName.insert("alpha");
+  collectionName.insert("beta");
+  collectionName.insert("gamma");
+
+  fAlpha = G4Alpha::Definition();
+  fElectron = G4Electron::Definition();
+  fPositron = G4Positron::Definition();
+  fGamma = G4Gamma::Definition();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TankSD::Initialize(G4HCofThisEvent* hce)
+{
+  G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+  for(G4int i = 0; i < kNSpecies; ++i)
+  {
+    fHitsMaps[i] =
+      new G4THitsMap<G4double>(SensitiveDetectorName, collectionName[i]);
+    hce->AddHitsCollection(sdManager->GetCollectionID(fHitsMaps[i]),
+                           fHitsMaps[i]);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TankSD::ProcessHits(G4Step* step, G4TouchableHistory*)
+{
+  const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+  if(preStepPoint->GetStepStatus() != fGeomBoundary)
+  {
+    return false;
+  }
+
+  const G4ParticleDefinition* particle =
+    step->GetTrack()->GetParticleDefinition();
+  G4int species = -1;
+  if(particle == fAlpha)
+  {
+    species = kAlpha;
+  }
+  else if(particle == fElectron || particle == fPositron)
+  {
+    species = kBeta;
+  }
+  else if(particle == fGamma)
+  {
+    species = kGamma;
+  }
+  else
+  {
+    return false;
+  }
+
+  // weighted by the source biasing, see DirectionBias
+  auto info =
+    static_cast<const TrackInformation*>(step->GetTrack()->GetUserInformation());
+  G4double entries = info ? info->GetWeight() : 1.;
+  fHitsMaps[species]->add(preStepPoint->GetTouchable()->GetCopyNumber(),
+                          entries);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
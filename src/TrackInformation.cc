@@ -46,10 +46,12 @@ TrackInformation::TrackInformation()
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
-TrackInformation::TrackInformation(const G4Track*)
+TrackInformation::TrackInformation(const G4Track* aTrack)
   : G4VUserTrackInformation()
 {
   fFirstTankX = true;
+  // primaries carry the weight given by PrimaryGeneratorAction
+  fWeight = aTrack->GetWeight();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -57,6 +59,7 @@ TrackInformation::TrackInformation(const TrackInformation* aTrackInfo)
   : G4VUserTrackInformation()
 {
   fFirstTankX = aTrackInfo->fFirstTankX;
+  fWeight = aTrackInfo->fWeight;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -67,6 +70,7 @@ TrackInformation& TrackInformation::operator=(
   const TrackInformation& aTrackInfo)
 {
   fFirstTankX = aTrackInfo.fFirstTankX;
+  fWeight = aTrackInfo.fWeight;
 
   return *this;
 }
@@ -80,7 +84,8 @@ void TrackInformation::SetSourceTrackInformation(const G4Track*)
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 void TrackInformation::Print() const
 {
-  G4cout << "first time track incident on X: " << fFirstTankX << G4endl;
+  G4cout << "first time track incident on X: " << fFirstTankX
+         << ", weight: " << fWeight << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
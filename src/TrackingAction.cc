@@ -48,7 +48,9 @@ void TrackingAction::PreUserTrackingAction(const G4Track* aTrack)
     aTrack->SetUserInformation(trackInfo);
   }
 
-  trackInfo->SetIsFirstTankX(true);
+  // a copy split by the weight window continues its photon, which may
+  // already have crossed the first surface
+  if(!trackInfo->IsSplitCopy()) trackInfo->SetIsFirstTankX(true);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -63,6 +65,8 @@ void TrackingAction::PostUserTrackingAction(const G4Track* aTrack)
     {
       for(size_t i = 0; i < nSeco; ++i)
       {
+        // copies made by the weight window already carry their own
+        if((*secondaries)[i]->GetUserInformation()) continue;
         auto infoNew = new TrackInformation(info);
         (*secondaries)[i]->SetUserInformation(infoNew);
       }